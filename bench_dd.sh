@@ -0,0 +1,171 @@
+#!/bin/bash
+
+# Reproducible throughput comparison of pdd against the system dd.
+# Every case of the matrix is run BENCH_REPEAT times per tool and summarized as
+# median and p95 throughput in $BENCH_OUT/results.csv and $BENCH_OUT/results.json.
+#
+# The matrix can be narrowed through the environment, e.g.
+#   BENCH_SIZES="64M" BENCH_BLOCK_SIZES="4K 1M" BENCH_REPEAT=3 make bench
+
+# Colors
+RED='\033[0;31m'; GREEN='\033[0;32m'; BLUE='\033[0;34m'; NC='\033[0m'
+
+BENCH_SIZES=${BENCH_SIZES:-"64M 512M 8G"}
+BENCH_BLOCK_SIZES=${BENCH_BLOCK_SIZES:-"512 4K 64K 1M 64M"}
+BENCH_MODES=${BENCH_MODES:-"buffered direct pipe"}
+BENCH_REPEAT=${BENCH_REPEAT:-5}
+BENCH_MAX_RECORDS=${BENCH_MAX_RECORDS:-4194304} # skip cases that need more records than this
+BENCH_TMPFS_DIR=${BENCH_TMPFS_DIR:-/dev/shm}
+BENCH_DISK_DIR=${BENCH_DISK_DIR:-$PWD/bench_dir}
+BENCH_OUT=${BENCH_OUT:-$PWD/bench_results}
+PDD="$PWD/pdd"
+
+# Convert sizes with K/M/G suffixes to bytes
+to_bytes() {
+    local n=${1%[KMGkmg]}
+    case "$1" in
+        *[Kk]) echo $((n * 1024)) ;;
+        *[Mm]) echo $((n * 1024 * 1024)) ;;
+        *[Gg]) echo $((n * 1024 * 1024 * 1024)) ;;
+        *) echo "$1" ;;
+    esac
+}
+
+# Free bytes in the filesystem holding a directory
+free_bytes() {
+    df -Pk "$1" 2>/dev/null | awk 'NR == 2 { printf "%.0f\n", $4 * 1024 }'
+}
+
+# Flush dirty data and, when permitted, the page cache so runs start cold
+settle() {
+    sync
+    [ -w /proc/sys/vm/drop_caches ] && echo 3 > /proc/sys/vm/drop_caches 2>/dev/null
+}
+
+now() {
+    date +%s.%N
+}
+
+# Build the command line of one run: tool, mode, input, output, block size
+bench_cmd() {
+    local tool=$1 mode=$2 in=$3 out=$4 bs=$5
+    case "$tool:$mode" in
+        pdd:buffered) echo "$PDD if=$in of=$out bs=$bs" ;;
+        pdd:direct) echo "$PDD if=$in of=$out bs=$bs direct" ;;
+        pdd:pipe) echo "cat $in | $PDD of=$out bs=$bs" ;;
+        dd:buffered) echo "dd if=$in of=$out bs=$bs" ;;
+        dd:direct) echo "dd if=$in of=$out bs=$bs iflag=direct oflag=direct" ;;
+        dd:pipe) echo "cat $in | dd of=$out bs=$bs iflag=fullblock" ;;
+    esac
+}
+
+# Median and p95 (nearest rank) of the throughput samples on stdin
+summarize() {
+    sort -g | awk '{ v[NR] = $1 } END {
+        if (NR == 0) { print "NA NA NA NA"; exit }
+        m = (NR % 2) ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2
+        r = int(0.95 * NR); if (r < 0.95 * NR) r++
+        printf "%.2f %.2f %.2f %.2f\n", m, v[r], v[1], v[NR]
+    }'
+}
+
+# Run one case BENCH_REPEAT times and append its summary to the result files
+run_case() {
+    local backing=$1 dir=$2 size=$3 bytes=$4 bs=$5 mode=$6 tool=$7
+    local in="$dir/bench_in.bin" out="$dir/bench_out.bin" status=ok samples=""
+    local cmd=$(bench_cmd "$tool" "$mode" "$in" "$out" "$bs")
+
+    echo -n "$backing $mode size=$size bs=$bs $tool: "
+    if [ $((bytes / $(to_bytes "$bs"))) -gt "$BENCH_MAX_RECORDS" ]; then
+        status=skipped
+    else
+        for ((run = 1; run <= BENCH_REPEAT; run++)); do
+            rm -f "$out"; settle
+            local start=$(now)
+            if ! eval "$cmd" >/dev/null 2>&1; then
+                status=failed; break
+            fi
+            local end=$(now)
+            # the first run of every case also checks the copy
+            if [ $run -eq 1 ] && ! cmp -s "$in" "$out"; then
+                status=mismatch; break
+            fi
+            samples+="$(awk -v b="$bytes" -v s="$start" -v e="$end" 'BEGIN { printf "%.2f", b / 1048576 / (e - s) }') "
+        done
+    fi
+    rm -f "$out"
+
+    [ "$status" = ok ] || samples=""
+    read -r median p95 min max <<< "$(printf '%s\n' $samples | grep . | summarize)"
+    case "$status" in
+        ok) echo -e "${GREEN}median $median MB/s, p95 $p95 MB/s${NC}" ;;
+        skipped) echo "skipped (more than $BENCH_MAX_RECORDS records)" ;;
+        *) echo -e "${RED}$status${NC}" ;;
+    esac
+
+    echo "$tool,$backing,$mode,$bytes,$(to_bytes "$bs"),$BENCH_REPEAT,$median,$p95,$min,$max,$status" >> "$BENCH_OUT/results.csv"
+    [ -s "$BENCH_OUT/results.json.tmp" ] && echo "," >> "$BENCH_OUT/results.json.tmp"
+    printf '  {"tool": "%s", "backing": "%s", "mode": "%s", "size": %s, "bs": %s, "runs": %s, "median_mbps": %s, "p95_mbps": %s, "min_mbps": %s, "max_mbps": %s, "status": "%s"}' \
+        "$tool" "$backing" "$mode" "$bytes" "$(to_bytes "$bs")" "$BENCH_REPEAT" \
+        "$(json_number "$median")" "$(json_number "$p95")" "$(json_number "$min")" "$(json_number "$max")" \
+        "$status" >> "$BENCH_OUT/results.json.tmp"
+}
+
+json_number() {
+    [ "$1" = NA ] && echo null || echo "$1"
+}
+
+# Main execution
+[ ! -x "./pdd" ] && { echo "Please run 'make' first to build the program"; exit 1; }
+
+[ -d "$BENCH_DISK_DIR" ] || created_disk_dir=1
+rm -rf "$BENCH_OUT"; mkdir -p "$BENCH_OUT" "$BENCH_DISK_DIR"
+# scratch files go to a private subdirectory, BENCH_DISK_DIR itself is left alone
+disk_dir=$(mktemp -d "$BENCH_DISK_DIR/pdd_bench.XXXXXX") || { echo "cannot create a directory in $BENCH_DISK_DIR"; exit 1; }
+echo "tool,backing,mode,size,bs,runs,median_mbps,p95_mbps,min_mbps,max_mbps,status" > "$BENCH_OUT/results.csv"
+: > "$BENCH_OUT/results.json.tmp"
+
+echo -e "${BLUE}pdd: $(git describe --always --dirty 2>/dev/null || echo unknown), dd: $(dd --version 2>/dev/null | head -1 || echo system dd)${NC}"
+echo "sizes: $BENCH_SIZES | bs: $BENCH_BLOCK_SIZES | modes: $BENCH_MODES | runs: $BENCH_REPEAT"
+[ -w /proc/sys/vm/drop_caches ] || echo "note: page cache is not dropped between runs (needs root)"
+
+for backing in tmpfs disk; do
+    dir=$([ $backing = tmpfs ] && echo "$BENCH_TMPFS_DIR/pdd_bench.$$" || echo "$disk_dir")
+    mkdir -p "$dir" || continue
+    for size in $BENCH_SIZES; do
+        bytes=$(to_bytes "$size")
+        # input and output must both fit
+        if [ "$(free_bytes "$dir")" -lt $((bytes * 2)) ]; then
+            echo "$backing size=$size: skipped, not enough space in $dir"
+            continue
+        fi
+        head -c "$bytes" /dev/urandom > "$dir/bench_in.bin"
+        for bs in $BENCH_BLOCK_SIZES; do
+            for mode in $BENCH_MODES; do
+                for tool in pdd dd; do
+                    run_case "$backing" "$dir" "$size" "$bytes" "$bs" "$mode" "$tool"
+                done
+            done
+        done
+        rm -f "$dir/bench_in.bin"
+    done
+    rm -rf "$dir"
+done
+[ -n "$created_disk_dir" ] && rmdir "$BENCH_DISK_DIR" 2>/dev/null
+
+{ echo "["; cat "$BENCH_OUT/results.json.tmp"; echo; echo "]"; } > "$BENCH_OUT/results.json"
+rm -f "$BENCH_OUT/results.json.tmp"
+
+echo -e "\n${BLUE}Results written to $BENCH_OUT/results.csv and $BENCH_OUT/results.json${NC}"
+# wrong output, or a case pdd fails while dd handles it, is a regression
+regressions=$(awk -F, 'NR > 1 {
+        key = $2 "," $3 "," $4 "," $5; st[$1 "," key] = $11; keys[key] = 1
+    } END {
+        for (k in keys)
+            if (st["pdd," k] == "mismatch" || st["dd," k] == "mismatch" || (st["pdd," k] == "failed" && st["dd," k] == "ok"))
+                print k
+    }' "$BENCH_OUT/results.csv")
+if [ -n "$regressions" ]; then
+    echo -e "${RED}Regressions (backing,mode,size,bs):${NC}"; echo "$regressions"; exit 1
+fi
+echo -e "${GREEN}No regressions against dd.${NC}"; exit 0
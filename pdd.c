@@ -1,11 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
-#include <sys/time.h>
+#include <sys/statvfs.h>
+#include <time.h>
 #include <ctype.h>
 #include <sys/ioctl.h>
 #include <signal.h>
@@ -14,12 +16,32 @@
 #include <stdbool.h>
 #include <pthread.h>
 #include <stdatomic.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
 
 #ifdef HAVE_LINUX_FEATURES
 #include <linux/fs.h>
+#include <sys/sysmacros.h>
 #define HAVE_DIRECT_IO 1
 #define HAVE_BLOCK_SIZE_IOCTL 1
 #define IO_DIRECT_FLAG O_DIRECT
+#define HAVE_SPLICE 1
+#define HAVE_COPY_FILE_RANGE 1
+#define HAVE_SYNC_FILE_RANGE 1
+#define HAVE_FADVISE 1
+#ifdef FICLONERANGE
+#define HAVE_CLONE_RANGE 1
+#endif
+#if defined(__has_include) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define HAVE_IO_URING 1
+#endif
 #elif defined(__APPLE__)
 #include <sys/disk.h>
 #define HAVE_BLOCK_SIZE_IOCTL 1
@@ -35,12 +57,92 @@
 #define HAVE_BLOCK_SIZE_IOCTL 0
 #endif
 
-#define DEFAULT_BLOCK_SIZE (128 * 1024)    // 128 KB
+#ifndef HAVE_IO_URING
+#define HAVE_IO_URING 0
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SIGPIPE is caught by signal_handler() on systems without it
+#endif
+
+// vector units used for zero-block detection
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#ifndef HAVE_SPLICE
+#define HAVE_SPLICE 0
+#endif
+
+#ifndef HAVE_COPY_FILE_RANGE
+#define HAVE_COPY_FILE_RANGE 0
+#endif
+
+#ifndef HAVE_CLONE_RANGE
+#define HAVE_CLONE_RANGE 0
+#endif
+
+#ifndef HAVE_SYNC_FILE_RANGE
+#define HAVE_SYNC_FILE_RANGE 0
+#endif
+
+#ifndef HAVE_FADVISE
+#define HAVE_FADVISE 0
+#endif
+
+#define DEFAULT_BLOCK_SIZE (128 * 1024)    // 128 KB, used when bs= is omitted
+#define ROTATIONAL_BLOCK_SIZE (1024 * 1024) // minimum transfer size for spinning disks
+#define MAX_AUTO_BLOCK_SIZE (8 * 1024 * 1024) // upper bound for a topology-derived block size
+#define ROTATIONAL_QUEUE_DEPTH 2           // in-flight I/Os for spinning disks
+#define MAX_AUTO_QUEUE_DEPTH 32            // upper bound for a topology-derived queue depth
+#define MAX_AUTO_INFLIGHT (64 * 1024 * 1024) // bytes kept in flight by a derived queue depth
 #define MAX_BLOCK_SIZE (128 * 1024 * 1024) // 128 MB
 #define MIN_BLOCK_SIZE (512)               // 512 B
+#define DIRECT_IO_ALIGN 512                // O_DIRECT sector size when the endpoint reports none
 #define DEFAULT_BAR_WIDTH 20               // progress bar width
 #define MEGABYTE (1024 * 1024)             // 1 MB
 #define PROGRESS_SLEEP_USEC 100000         // 100 ms
+#define PROGRESS_LINE_SIZE 256             // bytes of one rendered progress frame
+#define CACHE_LINE_SIZE 64                 // per-thread statistics shards start on their own line
+#define METRICS_WINDOW_TICKS 100           // progress ticks in the windowed throughput (10 s)
+#define METRICS_REQUEST_MSEC 20            // time a metrics client gets to send an HTTP request
+#define METRICS_MIN_BUCKET_SHIFT 10        // smallest histogram bucket bound, 2^10 ns ~ 1 us
+#define METRICS_MAX_BUCKET_SHIFT 36        // largest histogram bucket bound, 2^36 ns ~ 69 s
+#define DEFAULT_QUEUE_DEPTH 8              // in-flight I/Os for async engines
+#define MAX_QUEUE_DEPTH 256                // upper bound for qd=
+#define DEFAULT_PIPELINE_DEPTH 4           // buffers shared by reader and writer threads
+#define MAX_PIPELINE_DEPTH 1024            // upper bound for pipeline=
+#define MAX_JOBS 64                        // upper bound for jobs=
+#define STRIPE_SIZE (1024 * 1024)          // bytes claimed at once by a jobs= worker
+#define COALESCE_SIZE (256 * 1024)         // smaller blocks are gathered into transfers of about this size
+#define MAX_CHUNK_SIZE (8 * 1024 * 1024)   // largest I/O buffer, bigger blocks are moved in chunks
+#define CHUNK_ALIGN 4096                   // chunks of a block stay aligned for direct I/O
+#define NOCACHE_WINDOW (8 * 1024 * 1024)   // bytes between page cache drops for nocache
+#define SPLICE_PIPE_SIZE (1024 * 1024)     // pipe buffer requested for splice transfers
+#define CLONE_CHUNK_SIZE (1024ULL * 1024 * 1024) // bytes shared per FICLONERANGE call
+#define RING_SPIN_LIMIT 64                 // yields before a ring wait starts sleeping
+#define RING_WAIT_USEC 100000              // longest sleep of a ring wait before stop_requested is rechecked
+#define AUTOTUNE_WINDOW_USEC 250000        // throughput measurement window for bs=auto
+#define AUTOTUNE_MIN_GAIN 1.05             // rate ratio that counts as an improvement
+#define AUTOTUNE_DROP 0.75                 // rate ratio that restarts a settled search
+#define AUTOTUNE_RECHECK_WINDOWS 40        // settled windows before searching again anyway
+#define AUTOTUNE_MIN_BLOCK_SIZE (16 * 1024) // smallest transfer size bs=auto tries
+#define AUTOTUNE_BLOCK_UNIT 4096           // bs=auto keeps sizes aligned for direct I/O
+#define TUNING_CACHE_FILE "pdd/tuning"     // tuning cache below $XDG_CACHE_HOME
+#define TUNING_CACHE_MAX_ENTRIES 64        // device pairs remembered in the tuning cache
+#define DEVICE_KEY_SIZE 128                // bytes for a device identity in the tuning cache
+#define LATENCY_SUB_BITS 4                 // log2 of linear sub-buckets per power of two
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS) // covers every 64-bit nanosecond value
+#define BENCH_DEFAULT_SIZE (256 * 1024 * 1024) // bytes of the file or device region bench uses
+#define BENCH_POINT_USEC 250000            // time spent on each bench configuration
+#define BENCH_PASSES 4                     // passes over the region that also end a configuration
+#define BENCH_MAX_SAMPLES 65536            // latency samples kept per configuration
+#define BENCH_GOOD_ENOUGH 0.95             // fraction of the best rate a recommendation may trade away
 
 // size suffixes for human-readable output
 typedef enum
@@ -54,19 +156,163 @@ typedef enum
 
 static const char *UNIT_STRINGS[] = {"B", "KB", "MB", "GB", "TB"};
 
+// copy engines selectable with engine=
+typedef enum
+{
+    ENGINE_AUTO,     // pick an engine from the endpoint types
+    ENGINE_SYNC,     // blocking read/write loop
+    ENGINE_URING,    // io_uring with qd= reads and writes in flight
+    ENGINE_PIPELINE, // reader and writer threads sharing a ring of buffers
+    ENGINE_JOBS,     // jobs= workers copying stripes with pread/pwrite
+    ENGINE_SPLICE,   // splice() between a pipe and a file, device or pipe
+    ENGINE_COPY_RANGE, // copy_file_range() between regular files
+    ENGINE_COUNT
+} CopyEngine;
+
+static const char *ENGINE_STRINGS[] = {"auto", "sync", "uring", "pipeline", "jobs", "splice",
+                                       "copy_file_range"};
+
+// reflink modes selectable with clone=
+typedef enum
+{
+    CLONE_OFF,    // always copy data
+    CLONE_AUTO,   // clone when the filesystem supports it, copy otherwise
+    CLONE_ALWAYS, // fail if the range cannot be cloned
+    CLONE_COUNT
+} CloneMode;
+
+static const char *CLONE_STRINGS[] = {"off", "auto", "always"};
+
+// handling of input holes selectable with holes=
+typedef enum
+{
+    HOLES_OFF,   // read holes like any other data
+    HOLES_SEEK,  // skip holes and seek over them in the output
+    HOLES_PUNCH, // skip holes and punch them out of the output
+    HOLES_COUNT
+} HoleMode;
+
+static const char *HOLE_STRINGS[] = {"off", "seek", "punch"};
+
+// output preallocation modes selectable with prealloc=
+typedef enum
+{
+    PREALLOC_AUTO,      // allocate the known transfer size up front
+    PREALLOC_OFF,       // let writes allocate blocks
+    PREALLOC_KEEP_SIZE, // allocate blocks without changing the file size
+    PREALLOC_COUNT
+} PreallocMode;
+
+static const char *PREALLOC_STRINGS[] = {"auto", "off", "keep-size"};
+
+// reporting levels selectable with status=
+typedef enum
+{
+    STATUS_PROGRESS, // progress bar and final summary (default)
+    STATUS_NOXFER,   // progress bar and record counts, no transfer statistics
+    STATUS_NONE,     // errors only
+    STATUS_JSON,     // one JSON object with the run report, no progress bar
+    STATUS_COUNT
+} StatusMode;
+
+static const char *STATUS_STRINGS[] = {"progress", "noxfer", "none", "json"};
+
+// conversion flags selectable with conv=
+#define CONV_SPARSE (1u << 0) // seek over all-zero blocks instead of writing them
+
+typedef struct
+{
+    const char *name; // flag name in a comma-separated list
+    unsigned flag;    // bit set in the option mask
+} FlagName;
+
+static const FlagName CONV_FLAGS[] = {
+    {"sparse", CONV_SPARSE},
+    {NULL, 0}};
+
+// per-endpoint flags selectable with iflag= and oflag=
+#define IO_FLAG_NOCACHE (1u << 0)     // drop the file's page cache behind the copy
+#define IO_FLAG_DIRECT (1u << 1)      // open with O_DIRECT
+#define IO_FLAG_DSYNC (1u << 2)       // open with O_DSYNC
+#define IO_FLAG_SYNC (1u << 3)        // open with O_SYNC
+#define IO_FLAG_NONBLOCK (1u << 4)    // open with O_NONBLOCK
+#define IO_FLAG_NOATIME (1u << 5)     // open with O_NOATIME where permitted
+#define IO_FLAG_FULLBLOCK (1u << 6)   // accumulate full input blocks (always on in pdd)
+#define IO_FLAG_COUNT_BYTES (1u << 7) // count= is in bytes rather than blocks
+#define IO_FLAG_SKIP_BYTES (1u << 8)  // skip= is in bytes rather than blocks
+#define IO_FLAG_SEEK_BYTES (1u << 9)  // seek= is in bytes rather than blocks
+
+static const FlagName IFLAG_NAMES[] = {
+    {"direct", IO_FLAG_DIRECT},
+    {"dsync", IO_FLAG_DSYNC},
+    {"sync", IO_FLAG_SYNC},
+    {"nocache", IO_FLAG_NOCACHE},
+    {"nonblock", IO_FLAG_NONBLOCK},
+    {"noatime", IO_FLAG_NOATIME},
+    {"fullblock", IO_FLAG_FULLBLOCK},
+    {"count_bytes", IO_FLAG_COUNT_BYTES},
+    {"skip_bytes", IO_FLAG_SKIP_BYTES},
+    {NULL, 0}};
+
+static const FlagName OFLAG_NAMES[] = {
+    {"direct", IO_FLAG_DIRECT},
+    {"dsync", IO_FLAG_DSYNC},
+    {"sync", IO_FLAG_SYNC},
+    {"nocache", IO_FLAG_NOCACHE},
+    {"nonblock", IO_FLAG_NONBLOCK},
+    {"noatime", IO_FLAG_NOATIME},
+    {"seek_bytes", IO_FLAG_SEEK_BYTES},
+    {NULL, 0}};
+
 typedef struct
 {
     const char *if_path; // input file path
     const char *of_path; // output file path
-    size_t block_size;   // block size for I/O operations
+    size_t block_size;   // block size for I/O operations (0 = DEFAULT_BLOCK_SIZE)
+    size_t transfer_hint; // bytes per transfer the topology or tuning cache prefers (0 = none), never the block size
+    bool resume_tuning;   // bs=auto starts settled at the cached transfer_hint and queue_depth
+    bool auto_block_size; // bs=auto: retune transfer size and queue depth while copying
+    size_t in_block_size;  // ibs=: input record size (0 = bs)
+    size_t out_block_size; // obs=: output record size (0 = bs)
     size_t count;        // number of blocks to copy (0 = all)
-    off_t skip;          // blocks to skip at input start
-    off_t seek;          // blocks to seek at output start
-    bool sync_flag;      // use synchronized I/O
-    bool direct_flag;    // use direct I/O if available
+    off_t skip;          // blocks (or bytes with iflag=skip_bytes) to skip at input start
+    off_t seek;          // blocks (or bytes with oflag=seek_bytes) to seek at output start
+    bool sync_flag;      // use synchronized I/O, same as oflag=sync
+    bool direct_flag;    // use direct I/O if available, same as iflag=direct oflag=direct
     bool fsync_flag;     // force sync after each write
+    CopyEngine engine;   // copy engine to use
+    size_t queue_depth;  // in-flight I/Os for async engines (0 = derive from device topology)
+    size_t pipeline_depth; // buffers in the reader/writer ring
+    size_t jobs;         // worker threads for striped copies
+    CloneMode clone;     // share extents with FICLONERANGE instead of copying
+    HoleMode holes;      // skip unallocated input ranges found with SEEK_DATA/SEEK_HOLE
+    unsigned conv;       // CONV_* conversion flags
+    PreallocMode prealloc; // fallocate the output before copying
+    size_t sync_window;  // bytes per write-behind window (0 = off)
+    unsigned iflags;     // IO_FLAG_* flags for the input
+    unsigned oflags;     // IO_FLAG_* flags for the output
+    bool show_platform;  // print capabilities and detected topology instead of copying
+    const char *bench_path; // file, device or directory to benchmark (NULL = copy)
+    size_t bench_size;   // bytes of the region bench uses (0 = default)
+    StatusMode status;   // what is reported while and after copying
+    const char *metrics_path; // Unix socket serving Prometheus metrics (NULL = off)
+    size_t max_memory;   // maxmem=: bytes all I/O buffers of the copy may use together (0 = no budget)
 } Options;
 
+// block layer limits of one endpoint, zero where unknown
+typedef struct
+{
+    bool is_block;         // endpoint is a block device
+    unsigned logical;      // logical sector size
+    unsigned physical;     // physical sector size
+    unsigned io_min;       // minimum efficient I/O size
+    unsigned io_opt;       // optimal I/O size, e.g. a RAID stripe
+    size_t max_io;         // largest request the queue accepts (max_sectors_kb)
+    int rotational;        // 1 = spinning disk, 0 = solid state, -1 = unknown
+    unsigned nr_requests;  // request slots in the device queue
+    uint64_t size;         // device size in bytes
+} DeviceTopology;
+
 typedef struct
 {
     int fd;           // file descriptor
@@ -74,13 +320,161 @@ typedef struct
     bool is_input;    // whether this is an input file
 } FileHandler;
 
+typedef struct
+{
+    off_t in_offset;  // input byte offset where copying starts
+    off_t out_offset; // output byte offset where writing starts
+    size_t limit;     // bytes to copy (0 = until EOF)
+} TransferRange;
+
+// request kinds with their own latency histogram
+typedef enum
+{
+    LAT_READ,  // read of one block
+    LAT_WRITE, // write of one block, or an in-kernel transfer of one block
+    LAT_SYNC,  // fsync, final flush or write-behind wait
+    LAT_KINDS
+} LatencyKind;
+
+static const char *LATENCY_STRINGS[] = {"read", "write", "sync"};
+
+// log-linear latency histogram in nanoseconds, written by one thread with relaxed atomics
+typedef struct
+{
+    uint64_t counts[LATENCY_BUCKETS]; // samples per bucket
+    uint64_t total;                   // samples recorded
+    uint64_t sum_ns;                  // time spent in all samples
+    uint64_t max_ns;                  // largest sample
+} LatencyHistogram;
+
+// write-behind state: start writeback per window and wait for the window before it
+typedef struct
+{
+    size_t window;     // window size in bytes (0 = disabled)
+    off_t start;       // output offset of the window being filled
+    off_t prev_start;  // output offset of the window under writeback
+    size_t prev_len;   // length of the window under writeback (0 = none)
+    bool drop_cache;   // drop each window from the page cache once written back
+    LatencyHistogram *latency; // where waits for writeback are recorded
+} WriteBehind;
+
+// drop-behind state for input pages that have already been consumed
+typedef struct
+{
+    size_t window;     // bytes between drops (0 = disabled)
+    off_t start;       // input offset of the first consumed byte still cached
+    size_t filled;     // consumed bytes since start
+} DropBehind;
+
+// settings searched by bs=auto
+typedef enum
+{
+    TUNE_BLOCK_SIZE,  // bytes per transfer
+    TUNE_QUEUE_DEPTH, // transfers in flight (async engines only)
+    TUNE_DIMS
+} TuneDimension;
+
+// hill-climbing state of one setting, moved by doubling or halving
+typedef struct
+{
+    size_t value;       // setting in use
+    size_t min;         // smallest setting to try
+    size_t max;         // largest setting to try
+    size_t unit;        // settings must stay multiples of this
+    size_t best;        // setting with the best rate in the current search
+    double best_rate;   // bytes per second measured at best
+    int direction;      // 1 = doubling, -1 = halving
+    unsigned reversals; // direction changes, the search ends after two
+} TuneDim;
+
+// runtime transfer size/queue depth tuner for bs=auto
+typedef struct
+{
+    bool enabled;             // bs=auto was given
+    TuneDim dims[TUNE_DIMS];  // searched settings
+    size_t active;            // dimension being searched
+    bool settled;             // search finished, only watching the rate
+    unsigned settled_windows; // windows since the search settled
+    double settled_rate;      // best rate seen since the search settled
+    double window_start;      // monotonic time the window started
+    size_t window_bytes;      // bytes completed in the window
+} Autotuner;
+
+// tuned settings remembered for an input/output device pair
+typedef struct
+{
+    char in_key[DEVICE_KEY_SIZE];  // identity of the input device
+    char out_key[DEVICE_KEY_SIZE]; // identity of the output device
+    size_t block_size;             // tuned transfer size
+    size_t queue_depth;            // tuned queue depth
+    CopyEngine engine;             // engine the settings were measured with
+    double rate;                   // measured throughput in MB/s
+} TuningEntry;
+
+// measurements of one bench configuration
+typedef struct
+{
+    bool write;         // sequential writes instead of reads
+    size_t block_size;  // bytes per request
+    size_t queue_depth; // requests in flight
+    double rate;        // bytes per second
+    double iops;        // requests per second
+    double lat_avg;     // mean request latency in microseconds
+    double lat_p99;     // 99th percentile request latency in microseconds
+} BenchResult;
+
+static const size_t BENCH_BLOCK_SIZES[] = {4096, 16384, 65536, 262144, 1048576, 4194304};
+static const size_t BENCH_QUEUE_DEPTHS[] = {1, 4, 16, 32};
+
+// cached data extent of the input, refreshed with SEEK_DATA/SEEK_HOLE
+typedef struct
+{
+    off_t data;  // start of the current data extent
+    off_t hole;  // end of the current data extent
+    bool valid;  // extent has been looked up
+} ExtentCursor;
+
+// counters of one copy thread: only the owner writes them, with relaxed atomic stores,
+// and readers go through stats_snapshot(), so the copy path never waits on a reader
+typedef struct
+{
+    _Alignas(CACHE_LINE_SIZE) unsigned seq; // odd while the owner updates bytes and blocks
+    size_t bytes;                         // bytes copied by this thread
+    size_t blocks;                        // blocks copied by this thread
+    size_t bytes_cloned;                  // bytes shared via reflink instead of copied
+    uint64_t wait_ns;                     // time spent waiting for buffers or completions
+    size_t queue_occupancy;               // requests or buffers in flight in async engines
+    LatencyHistogram latency[LAT_KINDS];  // per-request latencies by LatencyKind
+} StatsShard;
+
+// live statistics of a copy, one shard per copy thread
+typedef struct
+{
+    StatsShard *shards;        // cache-line aligned, shards[0] belongs to the main copy thread
+    size_t shard_count;        // number of shards
+    uint64_t start_ns;         // monotonic time when copy started
+    size_t queue_capacity;     // size of the async engine's queue or ring (0 = none)
+    size_t tuned_block_size;   // transfer size bs=auto settled on (0 = not tuned), set when the copy ends
+    size_t tuned_queue_depth;  // queue depth bs=auto settled on
+    double tuned_rate;         // bytes/sec measured at the tuned settings (0 = no full window)
+    CopyEngine engine;         // engine that ran the copy loop, after any fallback to sync
+} CopyStats;
+
+// consistent totals over all shards, taken by progress, metrics and the final report
 typedef struct
 {
     size_t blocks_copied;      // number of blocks copied
     size_t total_bytes_copied; // total bytes copied
-    struct timeval start_time; // time when copy started
+    size_t bytes_cloned;       // bytes shared via reflink instead of copied
+    size_t tuned_block_size;   // transfer size bs=auto settled on (0 = not tuned)
+    size_t tuned_queue_depth;  // queue depth bs=auto settled on
+    double tuned_rate;         // bytes/sec measured at the tuned settings (0 = no full window)
+    uint64_t wait_ns;          // time spent waiting for buffers or completions
+    size_t queue_occupancy;    // requests or buffers in flight in async engines
+    size_t queue_capacity;     // size of the async engine's queue or ring (0 = none)
     double elapsed_time;       // elapsed time in seconds
-} CopyStats;
+    LatencyHistogram latency[LAT_KINDS]; // per-request latencies by LatencyKind (last, see stats_snapshot())
+} StatsSnapshot;
 
 typedef struct
 {
@@ -90,6 +484,8 @@ typedef struct
     double eta;         // estimated time remaining
     char speed_str[32]; // human-readable speed
     char size_str[32];  // human-readable size
+    char total_str[32]; // human-readable logical size of the transfer
+    char alloc_str[32]; // human-readable allocated size of the transfer
 } ProgressInfo;
 
 typedef struct
@@ -98,77 +494,306 @@ typedef struct
     void (*handler)(Options *, const char *); // option handler function
 } OptionHandler;
 
+#if HAVE_IO_URING
+// minimal io_uring instance driven through raw syscalls
+typedef struct
+{
+    int fd;                    // ring file descriptor
+    unsigned *sq_head;         // submission queue head (kernel)
+    unsigned *sq_tail;         // submission queue tail (user)
+    unsigned *sq_mask;         // submission queue index mask
+    unsigned *sq_array;        // submission queue index array
+    unsigned *cq_head;         // completion queue head (user)
+    unsigned *cq_tail;         // completion queue tail (kernel)
+    unsigned *cq_mask;         // completion queue index mask
+    struct io_uring_sqe *sqes; // submission queue entries
+    struct io_uring_cqe *cqes; // completion queue entries
+    void *sq_ring;             // mapped submission ring
+    size_t sq_ring_size;       // size of submission ring mapping
+    void *cq_ring;             // mapped completion ring (may alias sq_ring)
+    size_t cq_ring_size;       // size of completion ring mapping
+    size_t sqes_size;          // size of sqe array mapping
+    unsigned pending;          // sqes queued but not yet submitted
+} IoUring;
+#endif
+
+typedef struct
+{
+    int in_fd;
+    int out_fd;
+    void *buffer;
+    void **pool;
+    size_t pool_count;
+    int metrics_fd;
+    const char *metrics_path;
+    const CopyStats *stats; // progress of the copy, for trimming a preallocated output on error
+    off_t prealloc_offset;  // output offset a preallocation to trim starts at (-1 = none)
+#if HAVE_IO_URING
+    IoUring *ring;
+#endif
+} ManagedResources;
+
+// single-producer/single-consumer ring of buffers between reader and writer threads
+typedef struct
+{
+    const Options *opts;                // copy options
+    const ManagedResources *res;        // file descriptors and buffer pool
+    const TransferRange *range;         // bytes to copy
+    StatsShard *shard;                  // counters of the reader thread
+    size_t *lengths;                    // bytes held by each buffer
+    size_t depth;                       // number of buffers in the ring
+    _Alignas(64) atomic_size_t head;    // buffers consumed by the writer
+    _Alignas(64) atomic_size_t tail;    // buffers filled by the reader
+    _Alignas(64) atomic_bool reader_done; // reader reached EOF, the limit or an error
+    atomic_bool writer_failed;          // writer gave up, reader should stop
+    int read_errno;                     // errno of a failed read, published with reader_done
+    pthread_mutex_t lock;               // protects sleeping on progress
+    pthread_cond_t progress;            // signalled when head, tail or a flag changes
+    atomic_uint sleepers;               // threads sleeping on progress, skips signalling if 0
+} PipelineRing;
+
+// work shared by the striped pread/pwrite workers
+typedef struct
+{
+    const Options *opts;           // copy options
+    const ManagedResources *res;   // file descriptors and buffer pool
+    const TransferRange *range;    // bytes to copy
+    CopyStats *stats;              // copy statistics, one shard per worker
+    size_t stripe_blocks;          // blocks per stripe
+    atomic_size_t next_stripe;     // next stripe index to claim
+    atomic_size_t end_block;       // first block past EOF (SIZE_MAX until found)
+    atomic_bool failed;            // a worker hit an error, all workers stop
+    int error_errno;               // errno of the first failure
+    const char *failure;           // description of the first failure
+    pthread_mutex_t failure_lock;  // protects error_errno and failure
+} StripeWork;
+
+typedef struct
+{
+    StripeWork *work; // shared work description
+    size_t id;        // worker index, selects the buffer in res->pool
+} StripeWorker;
+
 // flag for handling interruptions gracefully
 static volatile sig_atomic_t stop_requested = 0;
 
+// SIGUSR1 asks the progress thread for a metrics snapshot on stderr
+static volatile sig_atomic_t dump_requested = 0;
+static volatile sig_atomic_t dump_wake_fd = -1; // wake pipe of the progress thread (-1 = none)
+
+// zero-block check picked for this CPU by init_zero_detection()
+static bool (*is_zero_block)(const void *buf, size_t len);
+static const char *zero_block_impl = "generic";
+
 // progress tracking thread control
 typedef struct
 {
-    CopyStats *stats;          // copy statistics (shared)
+    const CopyStats *stats;    // copy statistics, read through snapshots
     size_t total_bytes;        // total bytes to copy
+    size_t allocated_bytes;    // allocated bytes within the transfer (0 = unknown)
+    bool show_progress;        // draw the progress bar on stderr
+    int metrics_fd;            // listening metrics socket (-1 = none)
+    int wake_fd[2];            // pipe that wakes the thread when the copy finishes (-1 = none)
     atomic_bool copy_finished; // indicates copy operation finished (atomic)
 } ProgressThreadData;
 
+// recent progress samples for instantaneous and windowed throughput
+typedef struct
+{
+    double time[METRICS_WINDOW_TICKS];   // elapsed seconds of each sample
+    size_t bytes[METRICS_WINDOW_TICKS];  // bytes copied at each sample
+    size_t count;                        // samples taken so far
+} ThroughputWindow;
+
 // signal and initialization
 static void signal_handler(int signum);
+static void dump_signal_handler(int signum);
 static void setup_signals(void);
+static void init_zero_detection(void);
 
 // size and formatting utilities
 static size_t parse_size(const char *str);
+static unsigned parse_flag_list(const char *value, const FlagName *table, const char *what);
 static void format_size(char *buf, size_t bufsize, double size);
 
 // progress tracking
-static void init_copy_stats(CopyStats *stats);
-static void update_copy_stats(CopyStats *stats);
-static void calculate_progress(ProgressInfo *info, const CopyStats *stats, size_t total_bytes);
-static void display_progress(const ProgressInfo *info);
+static int init_copy_stats(CopyStats *stats, size_t shards);
+static void free_copy_stats(CopyStats *stats);
+static void stats_add(StatsShard *shard, size_t bytes, size_t blocks);
+static void stats_add_wait(StatsShard *shard, uint64_t start_ns);
+static void stats_snapshot(const CopyStats *stats, StatsSnapshot *snap, bool with_latency);
+static void calculate_progress(ProgressInfo *info, const StatsSnapshot *stats, size_t total_bytes,
+                               size_t allocated_bytes);
+static bool display_progress(const ProgressInfo *info);
 static void *progress_thread_func(void *arg);
-static void init_progress_thread_data(ProgressThreadData *data, CopyStats *stats, size_t total_bytes);
+static void init_progress_thread_data(ProgressThreadData *data, const CopyStats *stats, size_t total_bytes);
+static void finish_progress_thread(ProgressThreadData *data, pthread_t thread, bool active);
+static int open_metrics_socket(const char *path);
+static void write_metrics(FILE *out, const StatsSnapshot *stats, const ProgressThreadData *data,
+                          const ThroughputWindow *window);
 
 // memory and I/O operations
-static size_t optimize_block_size(int fd);
+static void probe_topology(int fd, DeviceTopology *topo);
+static size_t optimize_block_size(const DeviceTopology *in, const DeviceTopology *out,
+                                  size_t *queue_depth);
 static int open_file(FileHandler *fh, const Options *opts);
 static void *allocate_aligned_buffer(size_t size);
 static void free_aligned_buffer(void *ptr);
-static int flush_buffer(int fd, bool is_output);
+static int flush_buffer(int fd, bool is_output, bool drop_cache);
+static void drop_cached_range(int fd, off_t offset, size_t len);
+static void write_behind_init(WriteBehind *wb, const Options *opts, off_t out_offset,
+                              LatencyHistogram *latency);
+static int write_behind_advance(WriteBehind *wb, int fd, off_t end);
+static void drop_behind_init(DropBehind *db, const Options *opts, off_t in_offset);
+static void drop_behind_advance(DropBehind *db, int fd, size_t bytes);
+static double monotonic_seconds(void);
+static uint64_t monotonic_ns(void);
+static size_t latency_bucket(uint64_t ns);
+static void latency_record(LatencyHistogram *hist, uint64_t start_ns);
+static void print_latency_report(FILE *out, const StatsSnapshot *stats);
+static void print_json_report(FILE *out, const Options *opts, const StatsSnapshot *stats);
+static void autotune_init(Autotuner *tuner, const Options *opts, size_t max_block_size, size_t max_depth);
+static void autotune_advance(Autotuner *tuner, size_t bytes);
+static void autotune_finish(const Autotuner *tuner, CopyStats *stats);
+static size_t sync_buffer_size(const Options *opts);
+static size_t transfer_size(const Options *opts);
+static size_t coalesced_size(const Options *opts, size_t block_size);
+static size_t logical_blocks(const Options *opts, size_t bytes);
+static size_t blocks_between(const Options *opts, size_t start, size_t end);
+static size_t buffer_count(const Options *opts);
+static size_t chunk_limit(const Options *opts);
+static bool device_key(int fd, char *key, size_t size);
+static bool tuning_cache_lookup(const TuningEntry *key, TuningEntry *entry);
+static void tuning_cache_store(const TuningEntry *entry);
+static int allocate_buffer_pool(ManagedResources *res, size_t count, size_t size);
+static void free_buffer_pool(ManagedResources *res);
+static bool is_seekable(int fd);
+static bool is_pipe(int fd);
+static bool is_regular(int fd);
+static bool clear_direct_io(int fd);
+static size_t direct_io_align(int fd);
+static size_t direct_io_retry(int fd, size_t len);
+static bool uses_direct_io(const Options *opts);
+static int open_flags_for(unsigned io_flags);
+static size_t hole_bytes_at(int fd, ExtentCursor *cursor, off_t pos);
+static size_t allocated_bytes_in(int fd, off_t start, off_t end);
+static int write_hole(const Options *opts, ManagedResources *res, off_t out_pos, size_t len);
+static int finalize_output_size(int fd, off_t end);
+static bool preallocate_output(const Options *opts, int fd, off_t offset, size_t len);
+static int skip_input(int fd, off_t bytes);
+
+// copy engines
+static int copy_loop_sync(const Options *opts, ManagedResources *res, CopyStats *stats,
+                          const TransferRange *range);
+static int copy_loop_reblock(const Options *opts, ManagedResources *res, CopyStats *stats,
+                             const TransferRange *range);
+static int copy_loop_pipeline(const Options *opts, ManagedResources *res, CopyStats *stats,
+                              const TransferRange *range);
+static int copy_loop_jobs(const Options *opts, ManagedResources *res, CopyStats *stats,
+                          const TransferRange *range);
+static CopyEngine select_engine(const Options *opts, const ManagedResources *res);
+static bool clone_file_range(const Options *opts, ManagedResources *res, CopyStats *stats,
+                             const TransferRange *range);
+#if HAVE_SPLICE
+static int copy_loop_splice(const Options *opts, ManagedResources *res, CopyStats *stats,
+                            const TransferRange *range);
+#endif
+#if HAVE_COPY_FILE_RANGE
+static int copy_loop_copy_range(const Options *opts, ManagedResources *res, CopyStats *stats,
+                                const TransferRange *range);
+#endif
+#if HAVE_IO_URING
+static int uring_init(IoUring *ring, unsigned entries);
+static void uring_destroy(IoUring *ring);
+static bool uring_probe(int ring_fd);
+static int uring_submit(IoUring *ring, unsigned wait_nr);
+static int copy_loop_uring(const Options *opts, ManagedResources *res, CopyStats *stats,
+                           const TransferRange *range);
+#endif
 
 // core functionality
 static int copy_file(Options *opts);
+static int run_bench(const Options *opts);
 static void validate_options(Options *opts);
 static int parse_option(Options *opts, const char *arg);
 
 // help and information
 static void print_usage(const char *program_name);
-static void print_platform_info(void);
+static void print_platform_info(const Options *opts);
 
 // option handlers
 static void handle_if(Options *opts, const char *value);
 static void handle_of(Options *opts, const char *value);
 static void handle_bs(Options *opts, const char *value);
+static void handle_ibs(Options *opts, const char *value);
+static void handle_obs(Options *opts, const char *value);
 static void handle_count(Options *opts, const char *value);
 static void handle_skip(Options *opts, const char *value);
 static void handle_seek(Options *opts, const char *value);
 static void handle_sync(Options *opts, const char *value);
 static void handle_direct(Options *opts, const char *value);
 static void handle_fsync(Options *opts, const char *value);
+static void handle_engine(Options *opts, const char *value);
+static void handle_qd(Options *opts, const char *value);
+static void handle_pipeline(Options *opts, const char *value);
+static void handle_threads(Options *opts, const char *value);
+static void handle_jobs(Options *opts, const char *value);
+static void handle_clone(Options *opts, const char *value);
+static void handle_holes(Options *opts, const char *value);
+static void handle_conv(Options *opts, const char *value);
+static void handle_prealloc(Options *opts, const char *value);
+static void handle_syncwin(Options *opts, const char *value);
+static void handle_iflag(Options *opts, const char *value);
+static void handle_oflag(Options *opts, const char *value);
 static void handle_platform(Options *opts, const char *value);
-
-typedef struct
-{
-    int in_fd;
-    int out_fd;
-    void *buffer;
-} ManagedResources;
+static void handle_bench(Options *opts, const char *value);
+static void handle_benchsize(Options *opts, const char *value);
+static void handle_status(Options *opts, const char *value);
+static void handle_metrics(Options *opts, const char *value);
+static void handle_maxmem(Options *opts, const char *value);
 
 static void managed_resources_init(ManagedResources *res)
 {
     res->in_fd = -1;
     res->out_fd = -1;
     res->buffer = NULL;
+    res->pool = NULL;
+    res->pool_count = 0;
+    res->metrics_fd = -1;
+    res->metrics_path = NULL;
+    res->stats = NULL;
+    res->prealloc_offset = -1;
+#if HAVE_IO_URING
+    res->ring = NULL;
+#endif
+}
+
+// cut a preallocated output back to the bytes copied so far, so a failed copy does not
+// leave a full-length file whose zero-filled tail looks like copied data
+static void trim_preallocation(ManagedResources *res)
+{
+    if (res->prealloc_offset < 0 || !res->stats || res->out_fd < 0)
+        return;
+    StatsSnapshot snap;
+    stats_snapshot(res->stats, &snap, false);
+    off_t end = res->prealloc_offset + (off_t)snap.total_bytes_copied;
+    struct stat st;
+    if (fstat(res->out_fd, &st) == 0 && st.st_size > end && ftruncate(res->out_fd, end) == -1)
+        fprintf(stderr, "warning: cannot trim preallocated output: %s\n", strerror(errno));
+    res->prealloc_offset = -1;
 }
 
 static void managed_resources_destroy(ManagedResources *res)
 {
+#if HAVE_IO_URING
+    if (res->ring)
+    {
+        uring_destroy(res->ring);
+        free(res->ring);
+        res->ring = NULL;
+    }
+#endif
+    free_buffer_pool(res);
     if (res->buffer)
     {
         free_aligned_buffer(res->buffer);
@@ -184,6 +809,12 @@ static void managed_resources_destroy(ManagedResources *res)
         close(res->out_fd);
         res->out_fd = -1;
     }
+    if (res->metrics_fd >= 0)
+    {
+        close(res->metrics_fd);
+        unlink(res->metrics_path);
+        res->metrics_fd = -1;
+    }
 }
 
 static void error_exit(ManagedResources *res, const char *fmt, ...)
@@ -199,6 +830,7 @@ static void error_exit(ManagedResources *res, const char *fmt, ...)
             fprintf(stderr, ": %s (errno=%d)", strerror(errno), errno);
         fprintf(stderr, "\n");
     }
+    trim_preallocation(res);
     managed_resources_destroy(res);
     exit(EXIT_FAILURE);
 }
@@ -219,6 +851,16 @@ static void signal_handler(int signum)
     stop_requested = 1;
 }
 
+static void dump_signal_handler(int signum)
+{
+    dump_requested = 1;
+    // wake the progress thread even if it checked the flag just before blocking in poll()
+    int saved_errno = errno;
+    if (dump_wake_fd >= 0 && write(dump_wake_fd, "", 1) == -1)
+        ; // pipe full: a wakeup is pending anyway
+    errno = saved_errno;
+}
+
 // set up signal handlers for graceful termination
 static void setup_signals(void)
 {
@@ -231,6 +873,18 @@ static void setup_signals(void)
     sigaction(SIGTERM, &sa, NULL);
     sigaction(SIGHUP, &sa, NULL);
     sigaction(SIGPIPE, &sa, NULL);
+
+    // only the progress thread unblocks SIGUSR1, so it interrupts that thread's poll()
+    // and never a read or write on the copy path
+    struct sigaction dump = {
+        .sa_handler = dump_signal_handler,
+        .sa_flags = SA_RESTART};
+    sigemptyset(&dump.sa_mask);
+    sigaction(SIGUSR1, &dump, NULL);
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &usr1, NULL);
 }
 
 // parse a size string with optional unit suffix (K, M, G)
@@ -263,6 +917,31 @@ static size_t parse_size(const char *str)
     return 0; // unknown suffix
 }
 
+// parse a comma-separated list of flag names into a bit mask
+static unsigned parse_flag_list(const char *value, const FlagName *table, const char *what)
+{
+    unsigned flags = 0;
+    const char *p = value ? value : "";
+
+    while (*p)
+    {
+        size_t len = strcspn(p, ",");
+        const FlagName *entry = table;
+        while (entry->name && (strlen(entry->name) != len || strncmp(entry->name, p, len) != 0))
+            entry++;
+        if (!entry->name)
+        {
+            fprintf(stderr, "error: unknown %s flag: %.*s\n", what, (int)len, p);
+            exit(EXIT_FAILURE);
+        }
+        flags |= entry->flag;
+        p += len;
+        if (*p == ',')
+            p++;
+    }
+    return flags;
+}
+
 // format size with appropriate unit (B, KB, MB, GB, TB)
 static void format_size(char *buf, size_t bufsize, double size)
 {
@@ -277,26 +956,91 @@ static void format_size(char *buf, size_t bufsize, double size)
     snprintf(buf, bufsize, "%.2f %s", size, UNIT_STRINGS[unit]);
 }
 
-// initialize copy statistics
-static void init_copy_stats(CopyStats *stats)
+// initialize copy statistics with one shard per copy thread
+static int init_copy_stats(CopyStats *stats, size_t shards)
 {
     memset(stats, 0, sizeof(*stats));
-    gettimeofday(&stats->start_time, NULL);
+    stats->shards = aligned_alloc(CACHE_LINE_SIZE, shards * sizeof(StatsShard));
+    if (!stats->shards)
+        return -1;
+    memset(stats->shards, 0, shards * sizeof(StatsShard));
+    stats->shard_count = shards;
+    stats->start_ns = monotonic_ns();
+    return 0;
+}
+
+static void free_copy_stats(CopyStats *stats)
+{
+    free(stats->shards);
+    stats->shards = NULL;
+    stats->shard_count = 0;
+}
+
+// account copied data in the calling thread's shard; the sequence number lets readers
+// see bytes and blocks from the same update without taking a lock
+static void stats_add(StatsShard *shard, size_t bytes, size_t blocks)
+{
+    unsigned seq = shard->seq;
+    __atomic_store_n(&shard->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&shard->bytes, shard->bytes + bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&shard->blocks, shard->blocks + blocks, __ATOMIC_RELAXED);
+    __atomic_store_n(&shard->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// account the time since start_ns as waiting in the calling thread's shard
+static void stats_add_wait(StatsShard *shard, uint64_t start_ns)
+{
+    __atomic_store_n(&shard->wait_ns, shard->wait_ns + (monotonic_ns() - start_ns), __ATOMIC_RELAXED);
 }
 
-// update elapsed time in copy statistics
-static void update_copy_stats(CopyStats *stats)
+// sum all shards; latency histograms are only merged when asked for, they span many cache lines
+static void stats_snapshot(const CopyStats *stats, StatsSnapshot *snap, bool with_latency)
 {
-    struct timeval current_time;
-    gettimeofday(&current_time, NULL);
+    memset(snap, 0, with_latency ? sizeof(*snap) : offsetof(StatsSnapshot, latency));
+    for (size_t i = 0; i < stats->shard_count; i++)
+    {
+        const StatsShard *shard = &stats->shards[i];
+        unsigned before, after;
+        size_t bytes, blocks;
+        do
+        {
+            before = __atomic_load_n(&shard->seq, __ATOMIC_ACQUIRE);
+            bytes = __atomic_load_n(&shard->bytes, __ATOMIC_RELAXED);
+            blocks = __atomic_load_n(&shard->blocks, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            after = __atomic_load_n(&shard->seq, __ATOMIC_RELAXED);
+        } while ((before & 1) || before != after);
 
-    stats->elapsed_time =
-        (current_time.tv_sec - stats->start_time.tv_sec) +
-        (current_time.tv_usec - stats->start_time.tv_usec) / 1000000.0;
+        snap->total_bytes_copied += bytes;
+        snap->blocks_copied += blocks;
+        snap->bytes_cloned += __atomic_load_n(&shard->bytes_cloned, __ATOMIC_RELAXED);
+        snap->wait_ns += __atomic_load_n(&shard->wait_ns, __ATOMIC_RELAXED);
+        snap->queue_occupancy += __atomic_load_n(&shard->queue_occupancy, __ATOMIC_RELAXED);
+        if (!with_latency)
+            continue;
+
+        // buckets only grow, a histogram read while its owner records is off by a few samples at most
+        for (int kind = 0; kind < LAT_KINDS; kind++)
+        {
+            const LatencyHistogram *from = &shard->latency[kind];
+            LatencyHistogram *to = &snap->latency[kind];
+            for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+                to->counts[b] += __atomic_load_n(&from->counts[b], __ATOMIC_RELAXED);
+            to->total += __atomic_load_n(&from->total, __ATOMIC_RELAXED);
+            to->sum_ns += __atomic_load_n(&from->sum_ns, __ATOMIC_RELAXED);
+            uint64_t max = __atomic_load_n(&from->max_ns, __ATOMIC_RELAXED);
+            if (max > to->max_ns)
+                to->max_ns = max;
+        }
+    }
+    snap->queue_capacity = __atomic_load_n(&stats->queue_capacity, __ATOMIC_RELAXED);
+    snap->elapsed_time = (monotonic_ns() - stats->start_ns) / 1e9;
 }
 
 // calculate progress information based on copy statistics
-static void calculate_progress(ProgressInfo *info, const CopyStats *stats, size_t total_bytes)
+static void calculate_progress(ProgressInfo *info, const StatsSnapshot *stats, size_t total_bytes,
+                               size_t allocated_bytes)
 {
     if (stats->elapsed_time < 0.1)
         return;
@@ -320,290 +1064,3474 @@ static void calculate_progress(ProgressInfo *info, const CopyStats *stats, size_
     // format human-readable strings
     format_size(info->speed_str, sizeof(info->speed_str), info->speed);
     format_size(info->size_str, sizeof(info->size_str), stats->total_bytes_copied);
+    format_size(info->total_str, sizeof(info->total_str), total_bytes);
+    if (allocated_bytes > 0)
+        format_size(info->alloc_str, sizeof(info->alloc_str), allocated_bytes);
+    else
+        info->alloc_str[0] = '\0';
 }
 
-// display progress bar and statistics
-static void display_progress(const ProgressInfo *info)
+// render the progress bar and statistics into one frame and send it to stderr with a
+// single write, so frames never interleave with other output; false until there is data
+static bool display_progress(const ProgressInfo *info)
 {
-    // clear line and move cursor to start
-    printf("\r\033[K");
+    if (info->bar_width == 0)
+        return false; // calculate_progress() has not seen enough time yet
 
     // calculate completed bar width (rounded)
     int completed = (int)(info->bar_width * info->progress / 100.0 + 0.5);
     if (completed > info->bar_width)
         completed = info->bar_width;
 
-    // print progress bar
-    printf("[");
-    if (completed > 0)
-        printf("%.*s", completed, "===================="); // up to DEFAULT_BAR_WIDTH
+    // clear line and move cursor to start, then the bar
+    char line[PROGRESS_LINE_SIZE];
+    int len = snprintf(line, sizeof(line), "\r\033[K[%.*s", completed, "===================="); // up to DEFAULT_BAR_WIDTH
     if (completed < info->bar_width)
-        printf(">%*s", info->bar_width - completed - 1, "");
-    else if (completed == info->bar_width)
-        ; // bar full, no arrow
-    printf("] %3.0f%% | %8s | %8s/s",
-           info->progress,
-           info->size_str,
-           info->speed_str);
+        len += snprintf(line + len, sizeof(line) - len, ">%*s", info->bar_width - completed - 1, "");
+    len += snprintf(line + len, sizeof(line) - len, "] %3.0f%% | %8s | %8s/s",
+                    info->progress,
+                    info->size_str,
+                    info->speed_str);
+    // show logical and allocated size when holes are skipped
+    if (info->alloc_str[0])
+        len += snprintf(line + len, sizeof(line) - len, " | %s of %s allocated", info->alloc_str, info->total_str);
     // show ETA if meaningful
     if (info->eta > 0 && info->progress < 99.9)
-        printf(" | ETA: %.0fs", info->eta);
-    fflush(stdout);
+        len += snprintf(line + len, sizeof(line) - len, " | ETA: %.0fs", info->eta);
+    if (len >= (int)sizeof(line))
+        len = sizeof(line) - 1;
+
+    while (write(STDERR_FILENO, line, len) == -1 && errno == EINTR)
+        ;
+    return true;
 }
 
 // initialize the thread data structure for progress monitoring
-static void init_progress_thread_data(ProgressThreadData *data, CopyStats *stats, size_t total_bytes)
+static void init_progress_thread_data(ProgressThreadData *data, const CopyStats *stats, size_t total_bytes)
 {
     data->stats = stats;
     data->total_bytes = total_bytes;
+    data->allocated_bytes = 0;
+    data->show_progress = false;
+    data->metrics_fd = -1;
+    if (pipe(data->wake_fd) == -1)
+        data->wake_fd[0] = data->wake_fd[1] = -1; // the thread then notices the end at its next tick
+    for (int i = 0; i < 2; i++)
+        if (data->wake_fd[i] >= 0)
+            fcntl(data->wake_fd[i], F_SETFL, fcntl(data->wake_fd[i], F_GETFL) | O_NONBLOCK);
+    dump_wake_fd = data->wake_fd[1];
     atomic_init(&data->copy_finished, false);
 }
 
-// thread function to monitor and display progress
-static void *progress_thread_func(void *arg)
+// tell the progress thread the copy is over and wait for its last frame
+static void finish_progress_thread(ProgressThreadData *data, pthread_t thread, bool active)
 {
-    ProgressThreadData *data = (ProgressThreadData *)arg;
-    ProgressInfo info = {0};
-    for (;;)
+    atomic_store(&data->copy_finished, true);
+    if (active)
     {
-        CopyStats stats_copy = *data->stats;
-        update_copy_stats(&stats_copy);
-        calculate_progress(&info, &stats_copy, data->total_bytes);
-        display_progress(&info);
-        if (atomic_load(&data->copy_finished))
-            break;
-        usleep(PROGRESS_SLEEP_USEC);
+        if (data->wake_fd[1] >= 0)
+            while (write(data->wake_fd[1], "", 1) == -1 && errno == EINTR)
+                ;
+        pthread_join(thread, NULL);
     }
-    return NULL;
+    // SIGUSR1 is blocked everywhere else, so the handler cannot run past this point
+    dump_wake_fd = -1;
+    for (int i = 0; i < 2; i++)
+        if (data->wake_fd[i] >= 0)
+            close(data->wake_fd[i]);
 }
 
-// determine optimal block size for device
-static size_t optimize_block_size(int fd)
+// remember the bytes copied at this tick for the throughput gauges
+static void sample_throughput(ThroughputWindow *window, const StatsSnapshot *stats)
 {
-    struct stat st;
+    size_t i = window->count++ % METRICS_WINDOW_TICKS;
+    window->time[i] = stats->elapsed_time;
+    window->bytes[i] = stats->total_bytes_copied;
+}
 
-    // check if file is a block device
-    if (fstat(fd, &st) == 0 && S_ISBLK(st.st_mode))
-    {
-#if HAVE_BLOCK_SIZE_IOCTL
+// bytes/sec between the newest sample and the one `back` ticks older
+static double window_rate(const ThroughputWindow *window, size_t back)
+{
+    if (window->count < 2)
+        return 0;
+    if (back > window->count - 1)
+        back = window->count - 1;
+    size_t last = (window->count - 1) % METRICS_WINDOW_TICKS;
+    size_t first = (window->count - 1 - back) % METRICS_WINDOW_TICKS;
+    double seconds = window->time[last] - window->time[first];
+    return seconds > 0 ? (window->bytes[last] - window->bytes[first]) / seconds : 0;
+}
 
-#ifdef HAVE_LINUX_FEATURES
-        unsigned int block_size = 0;
-        // linux-specific ioctl
-        if (ioctl(fd, BLKPBSZGET, &block_size) == 0 && block_size > 0)
-            return block_size;
-#elif defined(__APPLE__)
-        // macOS-specific ioctl
-        uint32_t block_size = 0;
-        if (ioctl(fd, DKIOCGETBLOCKSIZE, &block_size) == 0 && block_size > 0)
-            return block_size;
-#elif defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
-        // BSD-specific ioctls
-        u_int block_size = 0;
-        if (ioctl(fd, DIOCGSECTORSIZE, &block_size) == 0 && block_size > 0)
-            return block_size;
-#endif
-#endif
-    }
-    return DEFAULT_BLOCK_SIZE;
+// print one metric family header in Prometheus text format
+static void metric_header(FILE *out, const char *name, const char *type, const char *help)
+{
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
 }
 
-// open file with appropriate flags based on options
-static int open_file(FileHandler *fh, const Options *opts)
+// write the current counters, throughput, queue occupancy and latency histograms
+// in the Prometheus text exposition format
+static void write_metrics(FILE *out, const StatsSnapshot *stats, const ProgressThreadData *data,
+                          const ThroughputWindow *window)
 {
-    // handle standard input/output
-    if (strcmp(fh->path, "-") == 0)
-    {
-        fh->fd = fh->is_input ? STDIN_FILENO : STDOUT_FILENO;
-        return 0;
-    }
+    metric_header(out, "pdd_bytes_copied_total", "counter", "Bytes copied so far.");
+    fprintf(out, "pdd_bytes_copied_total %zu\n", stats->total_bytes_copied);
+    metric_header(out, "pdd_blocks_copied_total", "counter", "Blocks copied so far.");
+    fprintf(out, "pdd_blocks_copied_total %zu\n", stats->blocks_copied);
+    metric_header(out, "pdd_bytes_cloned_total", "counter", "Bytes shared with reflinks instead of copied.");
+    fprintf(out, "pdd_bytes_cloned_total %zu\n", stats->bytes_cloned);
+    metric_header(out, "pdd_bytes_expected", "gauge", "Bytes the copy is expected to move (0 = unknown).");
+    fprintf(out, "pdd_bytes_expected %zu\n", data->total_bytes);
+    metric_header(out, "pdd_elapsed_seconds", "gauge", "Time since the copy started.");
+    fprintf(out, "pdd_elapsed_seconds %.3f\n", stats->elapsed_time);
 
-    int flags = fh->is_input ? O_RDONLY : (O_WRONLY | O_CREAT | O_TRUNC);
+    metric_header(out, "pdd_throughput_bytes_per_second", "gauge",
+                  "Copy rate over the last tick, the last 10 seconds and the whole run.");
+    fprintf(out, "pdd_throughput_bytes_per_second{window=\"instant\"} %.0f\n", window_rate(window, 1));
+    fprintf(out, "pdd_throughput_bytes_per_second{window=\"10s\"} %.0f\n",
+            window_rate(window, METRICS_WINDOW_TICKS - 1));
+    fprintf(out, "pdd_throughput_bytes_per_second{window=\"run\"} %.0f\n",
+            stats->elapsed_time > 0 ? stats->total_bytes_copied / stats->elapsed_time : 0.0);
 
-// add direct I/O flag if supported and requested
-#if HAVE_DIRECT_IO
-    if (opts->direct_flag)
+    metric_header(out, "pdd_queue_occupancy", "gauge", "Requests or buffers in flight in async engines.");
+    fprintf(out, "pdd_queue_occupancy %zu\n", stats->queue_occupancy);
+    metric_header(out, "pdd_queue_capacity", "gauge", "Queue or ring size of async engines (0 = none).");
+    fprintf(out, "pdd_queue_capacity %zu\n", stats->queue_capacity);
+    metric_header(out, "pdd_wait_seconds_total", "counter", "Time spent waiting for buffers or completions.");
+    fprintf(out, "pdd_wait_seconds_total %.6f\n", stats->wait_ns / 1e9);
+
+    // the log-linear buckets are folded into one Prometheus bucket per power of two
+    metric_header(out, "pdd_request_duration_seconds", "histogram", "Latency of single reads, writes and syncs.");
+    for (int kind = 0; kind < LAT_KINDS; kind++)
     {
-        flags |= IO_DIRECT_FLAG;
+        const LatencyHistogram *hist = &stats->latency[kind];
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (unsigned shift = METRICS_MIN_BUCKET_SHIFT; shift <= METRICS_MAX_BUCKET_SHIFT; shift++)
+        {
+            for (size_t end = latency_bucket(1ull << shift); bucket < end; bucket++)
+                cumulative += hist->counts[bucket];
+            fprintf(out, "pdd_request_duration_seconds_bucket{op=\"%s\",le=\"%g\"} %llu\n", LATENCY_STRINGS[kind],
+                    (double)(1ull << shift) / 1e9, (unsigned long long)cumulative);
+        }
+        fprintf(out, "pdd_request_duration_seconds_bucket{op=\"%s\",le=\"+Inf\"} %llu\n", LATENCY_STRINGS[kind],
+                (unsigned long long)hist->total);
+        fprintf(out, "pdd_request_duration_seconds_sum{op=\"%s\"} %.9f\n", LATENCY_STRINGS[kind],
+                hist->sum_ns / 1e9);
+        fprintf(out, "pdd_request_duration_seconds_count{op=\"%s\"} %llu\n", LATENCY_STRINGS[kind],
+                (unsigned long long)hist->total);
     }
-#endif
-
-    // add sync flag if requested for output files
-    if (!fh->is_input && opts->sync_flag)
-        flags |= O_SYNC;
-
-    fh->fd = open(fh->path, flags, fh->is_input ? 0 : 0666);
-    return fh->fd == -1 ? -1 : 0;
 }
 
-// allocate memory buffer aligned to page boundary
-static void *allocate_aligned_buffer(size_t size)
+// listen for metrics clients on a Unix socket, replacing a stale socket left at path
+static int open_metrics_socket(const char *path)
 {
-    void *buffer = NULL;
-
-    // get system page size for alignment
-    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
-    if (page_size == (size_t)-1)
-        page_size = 4096; // default if sysconf fails
-
-    size_t alignment = (page_size > 4096) ? page_size : 4096;
-
-    // ensure size is aligned to boundary
-    size = (size + alignment - 1) & ~(alignment - 1);
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(addr.sun_path, path, strlen(path) + 1);
 
-    if (posix_memalign(&buffer, alignment, size) != 0)
-        return NULL;
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
 
-    return buffer;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, 8) == -1 ||
+        fcntl(fd, F_SETFL, O_NONBLOCK) == -1 || fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+    {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
 }
 
-// free memory buffer allocated with allocate_aligned_buffer()
-static void free_aligned_buffer(void *ptr)
+// answer one metrics client; HTTP clients (curl --unix-socket, Prometheus) get a response
+// header, anything else (nc -U, socat) gets the bare text
+static void serve_metrics_client(int listen_fd, const StatsSnapshot *stats, const ProgressThreadData *data,
+                                 const ThroughputWindow *window)
 {
-    if (!ptr)
+    int client = accept(listen_fd, NULL, NULL);
+    if (client == -1)
         return;
-    free(ptr);
-}
-
-// flush buffer to disk
-static int flush_buffer(int fd, bool is_output)
-{
-    if (fd < 0 || !is_output)
-        return 0; // nothing to do for invalid fd or input files
-
-    int result = 0;
 
-#ifdef HAVE_LINUX_FEATURES
-    // linux-specific: data sync for output files only
-    result = fdatasync(fd);
-#else
-    // portable fallback: full sync
-    result = fsync(fd);
-#endif
+    bool http = false;
+    struct pollfd request = {.fd = client, .events = POLLIN};
+    char peek[4];
+    if (poll(&request, 1, METRICS_REQUEST_MSEC) == 1 &&
+        recv(client, peek, sizeof(peek), MSG_DONTWAIT) == (ssize_t)sizeof(peek))
+        http = memcmp(peek, "GET ", sizeof(peek)) == 0;
 
-    return result;
+    char *text = NULL;
+    size_t len = 0;
+    FILE *out = open_memstream(&text, &len);
+    if (out)
+    {
+        if (http)
+            fprintf(out, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n");
+        write_metrics(out, stats, data, window);
+        fclose(out);
+        for (size_t sent = 0; sent < len;)
+        {
+            ssize_t n = send(client, text + sent, len - sent, MSG_NOSIGNAL);
+            if (n <= 0 && errno != EINTR)
+                break;
+            if (n > 0)
+                sent += n;
+        }
+        free(text);
+    }
+    close(client);
+}
+
+// thread function to monitor and display progress
+static void *progress_thread_func(void *arg)
+{
+    ProgressThreadData *data = (ProgressThreadData *)arg;
+    ProgressInfo info = {0};
+    ThroughputWindow window = {.count = 0};
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    pthread_sigmask(SIG_UNBLOCK, &usr1, NULL);
+
+    // without a bar or metrics to refresh, the thread only wakes for SIGUSR1 and the end
+    bool ticking = data->show_progress || data->metrics_fd >= 0 || data->wake_fd[0] < 0;
+    bool drawn = false;
+    StatsSnapshot snap;
+    for (;;)
+    {
+        stats_snapshot(data->stats, &snap, false);
+        sample_throughput(&window, &snap);
+        if (data->show_progress)
+        {
+            calculate_progress(&info, &snap, data->total_bytes, data->allocated_bytes);
+            drawn |= display_progress(&info);
+        }
+        if (dump_requested)
+        {
+            dump_requested = 0;
+            stats_snapshot(data->stats, &snap, true);
+            if (drawn)
+                fputc('\n', stderr);
+            write_metrics(stderr, &snap, data, &window);
+            fflush(stderr);
+        }
+        if (atomic_load(&data->copy_finished))
+            break;
+
+        // sleep until the next tick, waking early for the end of the copy, metrics clients and SIGUSR1
+        struct pollfd pfd[2] = {{.fd = data->wake_fd[0], .events = POLLIN},
+                                {.fd = data->metrics_fd, .events = POLLIN}};
+        if (poll(pfd, 2, ticking ? PROGRESS_SLEEP_USEC / 1000 : -1) <= 0)
+            continue;
+        if (pfd[0].revents & POLLIN)
+        {
+            char drain[64];
+            while (read(data->wake_fd[0], drain, sizeof(drain)) > 0)
+                ;
+        }
+        if (pfd[1].revents & POLLIN)
+        {
+            stats_snapshot(data->stats, &snap, true);
+            serve_metrics_client(data->metrics_fd, &snap, data, &window);
+        }
+    }
+
+    // end the progress line so the report starts on its own line
+    if (drawn)
+        while (write(STDERR_FILENO, "\n", 1) == -1 && errno == EINTR)
+            ;
+    return NULL;
+}
+
+#ifdef HAVE_LINUX_FEATURES
+// read the first line of a block device sysfs attribute, looking at the parent disk for partitions
+static bool read_block_attr(dev_t dev, const char *name, char *buf, size_t size)
+{
+    static const char *const layouts[] = {"/sys/dev/block/%u:%u/%s",
+                                          "/sys/dev/block/%u:%u/../%s"};
+    char path[256];
+
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++)
+    {
+        snprintf(path, sizeof(path), layouts[i], major(dev), minor(dev), name);
+        FILE *f = fopen(path, "r");
+        if (!f)
+            continue;
+        char *line = fgets(buf, (int)size, f);
+        fclose(f);
+        if (!line)
+            continue;
+
+        // trim surrounding blanks, sysfs pads serials and models with spaces
+        size_t len = strlen(buf);
+        while (len > 0 && isspace((unsigned char)buf[len - 1]))
+            buf[--len] = '\0';
+        size_t lead = strspn(buf, " \t");
+        memmove(buf, buf + lead, len - lead + 1);
+        if (buf[0] != '\0')
+            return true;
+    }
+    return false;
+}
+
+// read a numeric queue attribute of a block device
+static bool read_queue_attr(dev_t dev, const char *name, unsigned long *value)
+{
+    char attr[64], buf[32];
+    snprintf(attr, sizeof(attr), "queue/%s", name);
+    if (!read_block_attr(dev, attr, buf, sizeof(buf)))
+        return false;
+    char *end;
+    *value = strtoul(buf, &end, 10);
+    return end != buf;
+}
+
+// find the filesystem UUID of the block device dev through /dev/disk/by-uuid
+static bool filesystem_uuid(dev_t dev, char *uuid, size_t size)
+{
+    DIR *dir = opendir("/dev/disk/by-uuid");
+    if (!dir)
+        return false;
+
+    bool found = false;
+    struct dirent *entry;
+    while (!found && (entry = readdir(dir)) != NULL)
+    {
+        char path[300];
+        struct stat st;
+        if (entry->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "/dev/disk/by-uuid/%s", entry->d_name);
+        size_t len = strlen(entry->d_name);
+        if (len < size && stat(path, &st) == 0 && S_ISBLK(st.st_mode) && st.st_rdev == dev)
+        {
+            memcpy(uuid, entry->d_name, len + 1);
+            found = true;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+#endif
+
+// build a stable identity for fd: serial or model of a disk, filesystem UUID of a file
+static bool device_key(int fd, char *key, size_t size)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        return false;
+
+    if (S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode))
+    {
+        snprintf(key, size, "pipe");
+        return true;
+    }
+
+    dev_t dev = S_ISBLK(st.st_mode) || S_ISCHR(st.st_mode) ? st.st_rdev : st.st_dev;
+#ifdef HAVE_LINUX_FEATURES
+    char id[DEVICE_KEY_SIZE / 2];
+    if (S_ISBLK(st.st_mode))
+    {
+        if (read_block_attr(dev, "device/serial", id, sizeof(id)) ||
+            read_block_attr(dev, "wwid", id, sizeof(id)))
+            snprintf(key, size, "serial=%s", id);
+        else if (read_block_attr(dev, "device/model", id, sizeof(id)))
+            snprintf(key, size, "model=%s@%u:%u", id, major(dev), minor(dev));
+        else
+            snprintf(key, size, "blk=%u:%u", major(dev), minor(dev));
+    }
+    else if (S_ISCHR(st.st_mode))
+        snprintf(key, size, "chr=%u:%u", major(dev), minor(dev));
+    else if (filesystem_uuid(dev, id, sizeof(id)))
+        snprintf(key, size, "uuid=%s", id);
+    else
+        snprintf(key, size, "fs=%u:%u", major(dev), minor(dev));
+#else
+    snprintf(key, size, "%s=%ju", S_ISBLK(st.st_mode) ? "blk" : S_ISCHR(st.st_mode) ? "chr" : "fs",
+             (uintmax_t)dev);
+#endif
+
+    // keys are whitespace-separated fields in the cache file
+    for (char *c = key; *c; c++)
+        if (isspace((unsigned char)*c))
+            *c = '_';
+    return true;
+}
+
+// path of the tuning cache, optionally creating its directory
+static bool tuning_cache_path(char *path, size_t size, bool create_dir)
+{
+    const char *base = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (base && base[0] == '/')
+        snprintf(path, size, "%s/%s", base, TUNING_CACHE_FILE);
+    else if (home && home[0] == '/')
+        snprintf(path, size, "%s/.cache/%s", home, TUNING_CACHE_FILE);
+    else
+        return false;
+
+    if (create_dir)
+    {
+        // create every missing directory above the cache file
+        for (char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/'))
+        {
+            *slash = '\0';
+            int r = mkdir(path, 0755);
+            *slash = '/';
+            if (r == -1 && errno != EEXIST)
+                return false;
+        }
+    }
+    return true;
+}
+
+// parse one cache line, returns false for comments and malformed lines
+static bool parse_tuning_entry(const char *line, TuningEntry *entry)
+{
+    char engine[32];
+    if (line[0] == '#' ||
+        sscanf(line, "%127s %127s %zu %zu %31s %lf", entry->in_key, entry->out_key, &entry->block_size,
+               &entry->queue_depth, engine, &entry->rate) != 6)
+        return false;
+    if (entry->block_size < MIN_BLOCK_SIZE || entry->block_size > MAX_BLOCK_SIZE ||
+        entry->queue_depth == 0 || entry->queue_depth > MAX_QUEUE_DEPTH)
+        return false;
+    for (int i = 0; i < ENGINE_COUNT; i++)
+    {
+        if (strcmp(engine, ENGINE_STRINGS[i]) == 0)
+        {
+            entry->engine = (CopyEngine)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// load the settings stored for the device pair in key, returns false on a miss
+static bool tuning_cache_lookup(const TuningEntry *key, TuningEntry *entry)
+{
+    char path[512], line[512];
+    if (!tuning_cache_path(path, sizeof(path), false))
+        return false;
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f))
+        found = parse_tuning_entry(line, entry) && strcmp(entry->in_key, key->in_key) == 0 &&
+                strcmp(entry->out_key, key->out_key) == 0;
+    fclose(f);
+    return found;
+}
+
+// replace the entry for a device pair, keeping the most recent entries
+static void tuning_cache_store(const TuningEntry *entry)
+{
+    char path[512], tmp_path[540], line[512];
+    if (!tuning_cache_path(path, sizeof(path), true))
+        return;
+
+    TuningEntry *entries = calloc(TUNING_CACHE_MAX_ENTRIES, sizeof(TuningEntry));
+    if (!entries)
+        return;
+    entries[0] = *entry;
+    size_t n = 1;
+
+    FILE *f = fopen(path, "r");
+    if (f)
+    {
+        TuningEntry old;
+        while (n < TUNING_CACHE_MAX_ENTRIES && fgets(line, sizeof(line), f))
+        {
+            if (parse_tuning_entry(line, &old) &&
+                (strcmp(old.in_key, entry->in_key) != 0 || strcmp(old.out_key, entry->out_key) != 0))
+                entries[n++] = old;
+        }
+        fclose(f);
+    }
+
+    // write a new file and rename it so concurrent runs never see a partial cache
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%ld", path, (long)getpid());
+    f = fopen(tmp_path, "w");
+    if (f)
+    {
+        fprintf(f, "# pdd tuning cache: input output transfer qd engine MB/s\n");
+        for (size_t i = 0; i < n; i++)
+            fprintf(f, "%s %s %zu %zu %s %.2f\n", entries[i].in_key, entries[i].out_key,
+                    entries[i].block_size, entries[i].queue_depth, ENGINE_STRINGS[entries[i].engine],
+                    entries[i].rate);
+        if (fclose(f) != 0 || rename(tmp_path, path) != 0)
+            unlink(tmp_path);
+    }
+    free(entries);
+}
+
+// fill topo with the block layer limits of fd, leaving zeros for regular files and pipes
+static void probe_topology(int fd, DeviceTopology *topo)
+{
+    struct stat st;
+
+    memset(topo, 0, sizeof(*topo));
+    topo->rotational = -1;
+    if (fstat(fd, &st) != 0 || !S_ISBLK(st.st_mode))
+        return;
+    topo->is_block = true;
+
+#if HAVE_BLOCK_SIZE_IOCTL
+
+#ifdef HAVE_LINUX_FEATURES
+    int logical = 0;
+    unsigned int value = 0;
+    uint64_t size = 0;
+    if (ioctl(fd, BLKSSZGET, &logical) == 0 && logical > 0)
+        topo->logical = (unsigned)logical;
+    if (ioctl(fd, BLKPBSZGET, &value) == 0)
+        topo->physical = value;
+    if (ioctl(fd, BLKIOMIN, &value) == 0)
+        topo->io_min = value;
+    if (ioctl(fd, BLKIOOPT, &value) == 0)
+        topo->io_opt = value;
+    if (ioctl(fd, BLKGETSIZE64, &size) == 0)
+        topo->size = size;
+
+    unsigned long attr;
+    if (read_queue_attr(st.st_rdev, "max_sectors_kb", &attr))
+        topo->max_io = (size_t)attr * 1024;
+    if (read_queue_attr(st.st_rdev, "rotational", &attr))
+        topo->rotational = attr ? 1 : 0;
+    if (read_queue_attr(st.st_rdev, "nr_requests", &attr))
+        topo->nr_requests = (unsigned)attr;
+#elif defined(__APPLE__)
+    // macOS-specific ioctls
+    uint32_t block_size = 0;
+    uint64_t block_count = 0;
+    if (ioctl(fd, DKIOCGETBLOCKSIZE, &block_size) == 0 && block_size > 0)
+        topo->logical = topo->physical = block_size;
+    if (ioctl(fd, DKIOCGETBLOCKCOUNT, &block_count) == 0)
+        topo->size = block_count * block_size;
+#elif defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    // BSD-specific ioctls
+    u_int block_size = 0;
+    if (ioctl(fd, DIOCGSECTORSIZE, &block_size) == 0 && block_size > 0)
+        topo->logical = topo->physical = block_size;
+#ifdef DIOCGMEDIASIZE
+    off_t media_size = 0;
+    if (ioctl(fd, DIOCGMEDIASIZE, &media_size) == 0 && media_size > 0)
+        topo->size = (uint64_t)media_size;
+#endif
+#endif
+#endif
+}
+
+// round size up to a multiple of unit, ignoring units that are unknown
+static size_t round_up_to(size_t size, size_t unit)
+{
+    if (unit == 0)
+        return size;
+    return (size + unit - 1) / unit * unit;
+}
+
+// transfer size one endpoint prefers (0 = no preference)
+static size_t preferred_block_size(const DeviceTopology *topo)
+{
+    if (!topo->is_block)
+        return 0;
+
+    // requests up to max_sectors_kb reach the device unsplit, spinning disks want them large
+    size_t size = topo->max_io > DEFAULT_BLOCK_SIZE ? topo->max_io : DEFAULT_BLOCK_SIZE;
+    if (topo->rotational == 1 && size < ROTATIONAL_BLOCK_SIZE)
+        size = ROTATIONAL_BLOCK_SIZE;
+    if (size > MAX_AUTO_BLOCK_SIZE)
+        size = MAX_AUTO_BLOCK_SIZE;
+    return size;
+}
+
+// in-flight I/Os one endpoint needs to stay busy (0 = no preference)
+static size_t preferred_queue_depth(const DeviceTopology *topo)
+{
+    if (!topo->is_block)
+        return 0;
+    if (topo->rotational == 1)
+        return ROTATIONAL_QUEUE_DEPTH;
+
+    // a quarter of the request slots leaves room for merging and other users of the device
+    size_t depth = topo->nr_requests / 4;
+    if (depth < DEFAULT_QUEUE_DEPTH)
+        depth = DEFAULT_QUEUE_DEPTH;
+    return depth > MAX_AUTO_QUEUE_DEPTH ? MAX_AUTO_QUEUE_DEPTH : depth;
+}
+
+// pick a transfer size and queue depth that keep both endpoints saturated
+static size_t optimize_block_size(const DeviceTopology *in, const DeviceTopology *out,
+                                  size_t *queue_depth)
+{
+    size_t in_bs = preferred_block_size(in);
+    size_t out_bs = preferred_block_size(out);
+    size_t block_size = in_bs > out_bs ? in_bs : out_bs;
+    if (block_size == 0)
+        block_size = DEFAULT_BLOCK_SIZE;
+
+    // keep every request aligned to the coarsest granularity of both devices
+    const DeviceTopology *topos[] = {in, out};
+    for (size_t i = 0; i < 2; i++)
+    {
+        const DeviceTopology *t = topos[i];
+        size_t unit = t->io_opt ? t->io_opt : t->io_min ? t->io_min : t->physical;
+        block_size = round_up_to(block_size, unit);
+    }
+    if (block_size > MAX_BLOCK_SIZE)
+        block_size = MAX_BLOCK_SIZE;
+
+    // the slower side bounds useful concurrency, and so does memory in flight
+    size_t in_qd = preferred_queue_depth(in);
+    size_t out_qd = preferred_queue_depth(out);
+    size_t depth = (in_qd && out_qd) ? (in_qd < out_qd ? in_qd : out_qd) : (in_qd ? in_qd : out_qd);
+    if (depth == 0)
+        depth = DEFAULT_QUEUE_DEPTH;
+    if (depth * block_size > MAX_AUTO_INFLIGHT)
+        depth = MAX_AUTO_INFLIGHT / block_size > 0 ? MAX_AUTO_INFLIGHT / block_size : 1;
+    *queue_depth = depth;
+
+    return block_size;
+}
+
+// describe a probed endpoint for the platform report
+static void print_topology(const char *label, const char *path, const DeviceTopology *topo)
+{
+    char size_str[32];
+
+    if (!topo->is_block)
+    {
+        printf("%s topology (%s): not a block device\n", label, path);
+        return;
+    }
+    format_size(size_str, sizeof(size_str), (double)topo->size);
+    printf("%s topology (%s): %s, logical %u, physical %u, io_min %u, io_opt %u\n", label, path,
+           size_str, topo->logical, topo->physical, topo->io_min, topo->io_opt);
+    printf("  max request %zu KB, %s, %u request slots\n", topo->max_io / 1024,
+           topo->rotational == 1 ? "rotational" : topo->rotational == 0 ? "non-rotational" : "rotational unknown",
+           topo->nr_requests);
+}
+
+// open file with appropriate flags based on options
+static int open_file(FileHandler *fh, const Options *opts)
+{
+    unsigned io_flags = fh->is_input ? opts->iflags : opts->oflags;
+
+    // handle standard input/output
+    if (strcmp(fh->path, "-") == 0)
+    {
+        fh->fd = fh->is_input ? STDIN_FILENO : STDOUT_FILENO;
+
+        // status flags can be changed on an inherited descriptor, best effort
+        int extra = open_flags_for(io_flags) & ~(O_SYNC | O_DSYNC);
+        int cur = fcntl(fh->fd, F_GETFL);
+        if (extra && cur != -1)
+            fcntl(fh->fd, F_SETFL, cur | extra);
+        return 0;
+    }
+
+    int flags = (fh->is_input ? O_RDONLY : (O_WRONLY | O_CREAT | O_TRUNC)) | open_flags_for(io_flags);
+
+    fh->fd = open(fh->path, flags, fh->is_input ? 0 : 0666);
+#ifdef O_NOATIME
+    // O_NOATIME is only allowed for the file owner, fall back to a normal open
+    if (fh->fd == -1 && errno == EPERM && (flags & O_NOATIME))
+        fh->fd = open(fh->path, flags & ~O_NOATIME, fh->is_input ? 0 : 0666);
+#endif
+    return fh->fd == -1 ? -1 : 0;
+}
+
+// translate IO_FLAG_* bits into open(2) flags
+static int open_flags_for(unsigned io_flags)
+{
+    int flags = 0;
+#if HAVE_DIRECT_IO
+    if (io_flags & IO_FLAG_DIRECT)
+        flags |= IO_DIRECT_FLAG;
+#endif
+    if (io_flags & IO_FLAG_SYNC)
+        flags |= O_SYNC;
+    if (io_flags & IO_FLAG_DSYNC)
+        flags |= O_DSYNC;
+    if (io_flags & IO_FLAG_NONBLOCK)
+        flags |= O_NONBLOCK;
+#ifdef O_NOATIME
+    if (io_flags & IO_FLAG_NOATIME)
+        flags |= O_NOATIME;
+#endif
+    return flags;
+}
+
+// check whether either endpoint was opened for direct I/O
+static bool uses_direct_io(const Options *opts)
+{
+    return ((opts->iflags | opts->oflags) & IO_FLAG_DIRECT) != 0;
+}
+
+// allocate memory buffer aligned to page boundary
+static void *allocate_aligned_buffer(size_t size)
+{
+    void *buffer = NULL;
+
+    // get system page size for alignment
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    if (page_size == (size_t)-1)
+        page_size = 4096; // default if sysconf fails
+
+    size_t alignment = (page_size > 4096) ? page_size : 4096;
+
+    // ensure size is aligned to boundary
+    size = (size + alignment - 1) & ~(alignment - 1);
+
+    if (posix_memalign(&buffer, alignment, size) != 0)
+        return NULL;
+
+    return buffer;
+}
+
+// free memory buffer allocated with allocate_aligned_buffer()
+static void free_aligned_buffer(void *ptr)
+{
+    if (!ptr)
+        return;
+    free(ptr);
+}
+
+// allocate count aligned buffers of the given size into res->pool
+static int allocate_buffer_pool(ManagedResources *res, size_t count, size_t size)
+{
+    res->pool = calloc(count, sizeof(void *));
+    if (!res->pool)
+        return -1;
+    res->pool_count = count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!(res->pool[i] = allocate_aligned_buffer(size)))
+            return -1;
+    }
+    return 0;
+}
+
+// free all buffers allocated with allocate_buffer_pool()
+static void free_buffer_pool(ManagedResources *res)
+{
+    if (!res->pool)
+        return;
+    for (size_t i = 0; i < res->pool_count; i++)
+        free_aligned_buffer(res->pool[i]);
+    free(res->pool);
+    res->pool = NULL;
+    res->pool_count = 0;
+}
+
+// flush buffer to disk, optionally dropping the written pages from the page cache
+static int flush_buffer(int fd, bool is_output, bool drop_cache)
+{
+    if (fd < 0 || !is_output)
+        return 0; // nothing to do for invalid fd or input files
+
+    int result = 0;
+
+#ifdef HAVE_LINUX_FEATURES
+    // linux-specific: data sync for output files only
+    result = fdatasync(fd);
+#else
+    // portable fallback: full sync
+    result = fsync(fd);
+#endif
+    if (result == -1 && errno == EINVAL)
+    {
+        errno = 0;
+        result = 0; // pipes and character devices cannot be synced
+    }
+    if (result == 0 && drop_cache)
+        drop_cached_range(fd, 0, 0); // clean pages can be dropped now
+
+    return result;
+}
+
+// ask the kernel to drop cached pages of a range (len 0 = to EOF)
+static void drop_cached_range(int fd, off_t offset, size_t len)
+{
+#if HAVE_FADVISE
+    posix_fadvise(fd, offset, len, POSIX_FADV_DONTNEED); // advisory, pipes report ESPIPE
+#endif
+}
+
+// prepare write-behind for output written sequentially from out_offset
+static void write_behind_init(WriteBehind *wb, const Options *opts, off_t out_offset,
+                              LatencyHistogram *latency)
+{
+    memset(wb, 0, sizeof(*wb));
+    wb->latency = latency;
+    wb->drop_cache = (opts->oflags & IO_FLAG_NOCACHE) != 0;
+    // dirty pages must be written back before they can be dropped
+    wb->window = opts->sync_window ? opts->sync_window : (wb->drop_cache ? NOCACHE_WINDOW : 0);
+    wb->start = out_offset;
+}
+
+// account output written up to offset end, which skipped holes count towards; once whole
+// windows are complete start their writeback and wait for the range before them, so dirty
+// data stays below two windows. Windows follow offsets, a jump over a hole is one range
+static int write_behind_advance(WriteBehind *wb, int fd, off_t end)
+{
+    if (wb->window == 0 || end - wb->start < (off_t)wb->window)
+        return 0;
+
+    size_t len = (size_t)(end - wb->start);
+    len -= len % wb->window;
+    uint64_t started = monotonic_ns();
+#if HAVE_SYNC_FILE_RANGE
+    if (sync_file_range(fd, wb->start, len, SYNC_FILE_RANGE_WRITE) == -1 ||
+        (wb->prev_len > 0 &&
+         sync_file_range(fd, wb->prev_start, wb->prev_len,
+                         SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                             SYNC_FILE_RANGE_WAIT_AFTER) == -1))
+    {
+        if (errno != ESPIPE && errno != EINVAL)
+            return -1;
+        wb->window = 0; // pipes and special files have no page cache to throttle
+        errno = 0;
+        return 0;
+    }
+#else
+    // portable fallback: bound dirty data with one sync per window
+    if (flush_buffer(fd, true, false) == -1)
+        return -1;
+#endif
+    latency_record(wb->latency, started);
+    if (wb->drop_cache && wb->prev_len > 0)
+        drop_cached_range(fd, wb->prev_start, wb->prev_len);
+    wb->prev_start = wb->start;
+    wb->prev_len = len;
+    wb->start += len;
+    return 0;
+}
+
+// prepare drop-behind for input consumed sequentially from in_offset
+static void drop_behind_init(DropBehind *db, const Options *opts, off_t in_offset)
+{
+    memset(db, 0, sizeof(*db));
+    db->window = (opts->iflags & IO_FLAG_NOCACHE) ? NOCACHE_WINDOW : 0;
+    db->start = in_offset;
+}
+
+// account consumed input bytes and drop them from the page cache once per window
+static void drop_behind_advance(DropBehind *db, int fd, size_t bytes)
+{
+    if (db->window == 0)
+        return;
+    db->filled += bytes;
+    if (db->filled >= db->window)
+    {
+        drop_cached_range(fd, db->start, db->filled);
+        db->start += db->filled;
+        db->filled = 0;
+    }
+}
+
+// seconds on a clock that does not jump with the wall time
+static double monotonic_seconds(void)
+{
+    return monotonic_ns() / 1e9;
+}
+
+// nanoseconds on the monotonic clock, used to time single requests
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// bucket of a latency: exact below LATENCY_SUB_BUCKETS ns, then LATENCY_SUB_BUCKETS per power of two
+static size_t latency_bucket(uint64_t ns)
+{
+    if (ns < LATENCY_SUB_BUCKETS)
+        return (size_t)ns;
+    unsigned msb = 63 - (unsigned)__builtin_clzll(ns);
+    unsigned shift = msb - LATENCY_SUB_BITS;
+    return (size_t)(shift + 1) * LATENCY_SUB_BUCKETS + (size_t)((ns >> shift) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+// smallest latency that falls into a bucket
+static uint64_t latency_bucket_floor(size_t bucket)
+{
+    size_t major = bucket / LATENCY_SUB_BUCKETS;
+    uint64_t sub = bucket % LATENCY_SUB_BUCKETS;
+    if (major == 0)
+        return sub;
+    return (LATENCY_SUB_BUCKETS + sub) << (major - 1);
+}
+
+// record the time since start_ns; each histogram lives in a StatsShard and only its
+// owner thread records, so plain relaxed stores suffice and no locked instruction is needed
+static void latency_record(LatencyHistogram *hist, uint64_t start_ns)
+{
+    if (!hist)
+        return;
+    uint64_t ns = monotonic_ns() - start_ns;
+    size_t bucket = latency_bucket(ns);
+    __atomic_store_n(&hist->counts[bucket], hist->counts[bucket] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&hist->total, hist->total + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&hist->sum_ns, hist->sum_ns + ns, __ATOMIC_RELAXED);
+    if (ns > hist->max_ns)
+        __atomic_store_n(&hist->max_ns, ns, __ATOMIC_RELAXED);
+}
+
+// latency below which the given fraction of samples fall, rounded up to the bucket edge
+static uint64_t latency_percentile(const LatencyHistogram *hist, double fraction)
+{
+    uint64_t rank = (uint64_t)(fraction * hist->total);
+    if (rank < fraction * hist->total)
+        rank++;
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += hist->counts[i];
+        if (seen >= rank)
+        {
+            uint64_t edge = (i + 1 < LATENCY_BUCKETS) ? latency_bucket_floor(i + 1) - 1 : UINT64_MAX;
+            return edge < hist->max_ns ? edge : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+// format a latency with a unit that keeps 3-4 significant digits
+static void format_latency(char *buf, size_t bufsize, uint64_t ns)
+{
+    if (ns < 1000000)
+        snprintf(buf, bufsize, "%.1fus", ns / 1e3);
+    else if (ns < 1000000000)
+        snprintf(buf, bufsize, "%.2fms", ns / 1e6);
+    else
+        snprintf(buf, bufsize, "%.2fs", ns / 1e9);
+}
+
+// print p50/p90/p99/p99.9/max for every request kind that was timed
+static void print_latency_report(FILE *out, const StatsSnapshot *stats)
+{
+    static const double fractions[] = {0.5, 0.9, 0.99, 0.999};
+    bool header = false;
+
+    for (int kind = 0; kind < LAT_KINDS; kind++)
+    {
+        const LatencyHistogram *hist = &stats->latency[kind];
+        if (hist->total == 0)
+            continue;
+        if (!header)
+        {
+            fprintf(out, "%-6s %10s %10s %10s %10s %10s %10s\n", "lat", "p50", "p90", "p99", "p99.9", "max", "count");
+            header = true;
+        }
+
+        char cells[5][16];
+        for (size_t i = 0; i < 4; i++)
+            format_latency(cells[i], sizeof(cells[i]), latency_percentile(hist, fractions[i]));
+        format_latency(cells[4], sizeof(cells[4]), hist->max_ns);
+        fprintf(out, "%-6s %10s %10s %10s %10s %10s %10llu\n", LATENCY_STRINGS[kind], cells[0], cells[1], cells[2],
+                cells[3], cells[4], (unsigned long long)hist->total);
+    }
+}
+
+// split the copied bytes into full records of block_size and a short final record; reads
+// always gather full input blocks, so only the end of the data can leave a partial record
+static void count_records(const StatsSnapshot *stats, size_t block_size, size_t *full, size_t *partial)
+{
+    *full = stats->total_bytes_copied / block_size;
+    *partial = (stats->total_bytes_copied % block_size != 0) ? 1 : 0;
+}
+
+// print the run report as one JSON object for scripts and orchestration
+static void print_json_report(FILE *out, const Options *opts, const StatsSnapshot *stats)
+{
+    size_t full_in, partial_in, full_out, partial_out;
+    count_records(stats, opts->in_block_size, &full_in, &partial_in);
+    count_records(stats, opts->out_block_size, &full_out, &partial_out);
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == -1)
+        memset(&usage, 0, sizeof(usage));
+
+    fprintf(out, "{\"bytes\":%zu,\"bytes_cloned\":%zu,", stats->total_bytes_copied, stats->bytes_cloned);
+    fprintf(out, "\"records_in\":{\"full\":%zu,\"partial\":%zu},", full_in, partial_in);
+    fprintf(out, "\"records_out\":{\"full\":%zu,\"partial\":%zu},", full_out, partial_out);
+    fprintf(out, "\"elapsed_s\":%.6f,\"throughput_bps\":%.0f,", stats->elapsed_time,
+            stats->elapsed_time > 0 ? stats->total_bytes_copied / stats->elapsed_time : 0.0);
+
+    // request times are summed over all requests, so they can exceed elapsed_s with several in flight
+    fprintf(out, "\"phase_s\":{");
+    for (int kind = 0; kind < LAT_KINDS; kind++)
+        fprintf(out, "\"%s\":%.6f,", LATENCY_STRINGS[kind], stats->latency[kind].sum_ns / 1e9);
+    fprintf(out, "\"wait\":%.6f},", stats->wait_ns / 1e9);
+
+    fprintf(out, "\"latency_ns\":{");
+    for (int kind = 0; kind < LAT_KINDS; kind++)
+    {
+        const LatencyHistogram *hist = &stats->latency[kind];
+        fprintf(out, "%s\"%s\":{\"count\":%llu", kind > 0 ? "," : "", LATENCY_STRINGS[kind],
+                (unsigned long long)hist->total);
+        if (hist->total > 0)
+            fprintf(out, ",\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p99.9\":%llu,\"max\":%llu",
+                    (unsigned long long)latency_percentile(hist, 0.5),
+                    (unsigned long long)latency_percentile(hist, 0.9),
+                    (unsigned long long)latency_percentile(hist, 0.99),
+                    (unsigned long long)latency_percentile(hist, 0.999), (unsigned long long)hist->max_ns);
+        fprintf(out, "}");
+    }
+    fprintf(out, "},");
+
+    fprintf(out, "\"cpu_s\":{\"user\":%.6f,\"sys\":%.6f},",
+            usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6,
+            usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6);
+    fprintf(out, "\"engine\":\"%s\",\"block_size\":%zu,\"transfer_size\":%zu,\"queue_depth\":%zu,\"auto_block_size\":%s,",
+            ENGINE_STRINGS[opts->engine], opts->block_size,
+            stats->tuned_block_size ? stats->tuned_block_size : transfer_size(opts),
+            stats->tuned_queue_depth ? stats->tuned_queue_depth : opts->queue_depth,
+            opts->auto_block_size ? "true" : "false");
+    fprintf(out, "\"interrupted\":%s}\n", stop_requested ? "true" : "false");
+}
+
+// set up bs=auto, starting from the configured transfer size and the full queue depth
+static void autotune_init(Autotuner *tuner, const Options *opts, size_t max_block_size, size_t max_depth)
+{
+    memset(tuner, 0, sizeof(*tuner));
+    tuner->enabled = opts->auto_block_size;
+
+    TuneDim *bs = &tuner->dims[TUNE_BLOCK_SIZE];
+    bs->value = transfer_size(opts); // bs=auto tunes the transfer size, blocks stay opts->block_size
+    bs->min = (opts->block_size < AUTOTUNE_MIN_BLOCK_SIZE) ? opts->block_size : AUTOTUNE_MIN_BLOCK_SIZE;
+    bs->max = (max_block_size > opts->block_size) ? max_block_size : opts->block_size;
+    bs->unit = AUTOTUNE_BLOCK_UNIT;
+
+    TuneDim *qd = &tuner->dims[TUNE_QUEUE_DEPTH];
+    qd->value = qd->max = max_depth;
+    qd->min = qd->unit = 1;
+
+    // an earlier run on these devices ended its search at the cached settings, watch their
+    // rate and search again only when it drops or the recheck interval passes
+    if (tuner->enabled && opts->resume_tuning)
+    {
+        size_t start = opts->transfer_hint;
+        bs->value = (start < bs->min) ? bs->min : (start > bs->max) ? bs->max : start;
+        bs->best = bs->value;
+        qd->best = qd->value;
+        tuner->settled = true;
+    }
+
+    tuner->active = TUNE_BLOCK_SIZE;
+    tuner->dims[TUNE_BLOCK_SIZE].direction = 1;
+    tuner->window_start = monotonic_seconds();
+}
+
+// move a setting one step in its direction, returns false at a bound
+static bool tune_step(TuneDim *dim)
+{
+    size_t next = (dim->direction > 0) ? dim->value * 2 : dim->value / 2;
+    if (next < dim->min || next > dim->max || next % dim->unit != 0)
+        return false;
+    dim->value = next;
+    return true;
+}
+
+// step a setting, turning around once at a bound, returns false when it has settled
+static bool tune_continue(TuneDim *dim)
+{
+    while (dim->reversals < 2)
+    {
+        if (tune_step(dim))
+            return true;
+        dim->direction = -dim->direction;
+        dim->reversals++;
+    }
+    dim->value = dim->best;
+    return false;
+}
+
+// start searching a dimension from its current value, measured at rate
+static bool tune_begin(Autotuner *tuner, size_t active, double rate)
+{
+    TuneDim *dim = &tuner->dims[active];
+    tuner->active = active;
+    dim->best = dim->value;
+    dim->best_rate = rate;
+    dim->direction = 1;
+    dim->reversals = 0;
+    return tune_continue(dim);
+}
+
+// feed one measured window into the hill climb
+static void tune_window(Autotuner *tuner, double rate)
+{
+    if (tuner->settled)
+    {
+        if (rate > tuner->settled_rate)
+            tuner->settled_rate = rate;
+
+        // a rate collapse means the device changed, e.g. an SSD write cache filled up
+        if (rate >= tuner->settled_rate * AUTOTUNE_DROP &&
+            ++tuner->settled_windows < AUTOTUNE_RECHECK_WINDOWS)
+            return;
+        tuner->settled = false;
+        if (tune_begin(tuner, TUNE_BLOCK_SIZE, rate))
+            return;
+    }
+    else
+    {
+        TuneDim *dim = &tuner->dims[tuner->active];
+        if (rate > dim->best_rate * AUTOTUNE_MIN_GAIN)
+        {
+            dim->best = dim->value;
+            dim->best_rate = rate;
+        }
+        else
+        {
+            // worse than the best setting, go back and try the other side
+            dim->value = dim->best;
+            dim->direction = -dim->direction;
+            dim->reversals++;
+        }
+        if (tune_continue(dim))
+            return;
+        if (tuner->active == TUNE_BLOCK_SIZE && tune_begin(tuner, TUNE_QUEUE_DEPTH, dim->best_rate))
+            return;
+    }
+
+    tuner->settled = true;
+    tuner->settled_windows = 0;
+    tuner->settled_rate = tuner->dims[tuner->active].best_rate;
+}
+
+// account completed bytes and retune once per measurement window
+static void autotune_advance(Autotuner *tuner, size_t bytes)
+{
+    if (!tuner->enabled)
+        return;
+    tuner->window_bytes += bytes;
+
+    double now = monotonic_seconds();
+    double elapsed = now - tuner->window_start;
+    if (elapsed * 1000000 < AUTOTUNE_WINDOW_USEC)
+        return;
+
+    tune_window(tuner, tuner->window_bytes / elapsed);
+    tuner->window_start = now;
+    tuner->window_bytes = 0;
+}
+
+// record the settings bs=auto ended with and the best rate measured for them
+static void autotune_finish(const Autotuner *tuner, CopyStats *stats)
+{
+    if (!tuner->enabled)
+        return;
+    stats->tuned_block_size = tuner->dims[TUNE_BLOCK_SIZE].value;
+    stats->tuned_queue_depth = tuner->dims[TUNE_QUEUE_DEPTH].value;
+    stats->tuned_rate = tuner->settled ? tuner->settled_rate : tuner->dims[tuner->active].best_rate;
+}
+
+// size of res->buffer, large enough for every transfer size bs=auto may try
+static size_t sync_buffer_size(const Options *opts)
+{
+    if (opts->auto_block_size && opts->block_size < MAX_AUTO_BLOCK_SIZE)
+        return (MAX_AUTO_BLOCK_SIZE < chunk_limit(opts)) ? MAX_AUTO_BLOCK_SIZE : chunk_limit(opts);
+    // reblocking keeps up to one output transfer buffered while the next input transfer arrives
+    if (opts->in_block_size != opts->out_block_size)
+        return coalesced_size(opts, opts->in_block_size) + coalesced_size(opts, opts->out_block_size);
+    return transfer_size(opts);
+}
+
+// bytes moved per read/write: blocks below COALESCE_SIZE are gathered into one larger
+// transfer of whole blocks, so bs=512 does not cost two syscalls per 512 bytes, and blocks
+// above chunk_limit() are moved in chunks, so bs=128M does not need 128 MB buffers
+static size_t transfer_size(const Options *opts)
+{
+    return coalesced_size(opts, opts->block_size);
+}
+
+// transfer size for whole blocks of block_size, see transfer_size(); a larger transfer the
+// device topology prefers is used when it holds at least one whole block
+static size_t coalesced_size(const Options *opts, size_t block_size)
+{
+    size_t size = block_size;
+    // conv=sparse judges and fsync syncs every block on its own
+    if (!(opts->conv & CONV_SPARSE) && !opts->fsync_flag)
+    {
+        if (block_size < COALESCE_SIZE)
+            size = COALESCE_SIZE - COALESCE_SIZE % block_size;
+        if (opts->transfer_hint > size)
+            size = opts->transfer_hint - opts->transfer_hint % block_size;
+    }
+    return (size > chunk_limit(opts)) ? chunk_limit(opts) : size;
+}
+
+// logical blocks (records) in a transfer, a trailing partial block counts as one
+static size_t logical_blocks(const Options *opts, size_t bytes)
+{
+    return (bytes + opts->block_size - 1) / opts->block_size;
+}
+
+// logical blocks starting in [start, end), so the chunks of one large block count it once
+static size_t blocks_between(const Options *opts, size_t start, size_t end)
+{
+    return logical_blocks(opts, end) - logical_blocks(opts, start);
+}
+
+// I/O buffers the copy engine holds at once, each at most chunk_limit() bytes
+static size_t buffer_count(const Options *opts)
+{
+    if (opts->in_block_size != opts->out_block_size)
+        return 2; // input and output side of the reblocking buffer
+    switch (opts->engine)
+    {
+    case ENGINE_PIPELINE:
+        return opts->pipeline_depth;
+    case ENGINE_JOBS:
+        return opts->jobs;
+    case ENGINE_URING:
+        return opts->queue_depth;
+    default:
+        return 1;
+    }
+}
+
+// largest I/O buffer: MAX_CHUNK_SIZE, or less when maxmem= is shared by many buffers
+static size_t chunk_limit(const Options *opts)
+{
+    size_t limit = MAX_CHUNK_SIZE;
+    size_t count = buffer_count(opts);
+    if (opts->max_memory > 0 && count > 0 && opts->max_memory / count < limit)
+        limit = opts->max_memory / count;
+    return limit - limit % CHUNK_ALIGN;
 }
 
 // ensure all bytes are read or an error occurs
 static ssize_t robust_read(int fd, void *buf, size_t nbytes)
 {
-    size_t total = 0;
-    char *p = (char *)buf;
-    while (total < nbytes)
+    size_t total = 0;
+    size_t cap = nbytes; // whole sectors of an unaligned O_DIRECT transfer, see direct_io_retry()
+    char *p = (char *)buf;
+    while (total < nbytes)
+    {
+        size_t len = (nbytes - total < cap) ? nbytes - total : cap;
+        ssize_t r = read(fd, p + total, len);
+        if (r == 0)
+            break; // EOF
+        if (r < 0 && errno == EINVAL && (cap = direct_io_retry(fd, len)) > 0)
+            continue;
+        if (r < 0)
+            return (total > 0) ? total : -1;
+        total += r;
+        cap = nbytes;
+    }
+    return total;
+}
+
+// robust_read() for a coalesced transfer: a short read that ends on a block boundary returns
+// early, so a slow pipe hands on its complete blocks instead of waiting for the whole transfer
+static ssize_t read_blocks(int fd, void *buf, size_t nbytes, size_t block_size)
+{
+    size_t total = 0;
+    size_t cap = nbytes; // whole sectors of an unaligned O_DIRECT transfer, see direct_io_retry()
+    char *p = (char *)buf;
+    while (total < nbytes)
+    {
+        size_t len = (nbytes - total < cap) ? nbytes - total : cap;
+        ssize_t r = read(fd, p + total, len);
+        if (r == 0)
+            break; // EOF
+        if (r < 0 && errno == EINVAL && (cap = direct_io_retry(fd, len)) > 0)
+            continue;
+        if (r < 0)
+            return (total > 0) ? total : -1;
+        total += r;
+        cap = nbytes;
+        if (total < nbytes && total % block_size == 0 && !is_regular(fd))
+            break; // nothing more buffered right now
+    }
+    return total;
+}
+
+// ensure all bytes are written or an error occurs
+static ssize_t robust_write(int fd, const void *buf, size_t nbytes)
+{
+    size_t total = 0;
+    size_t cap = nbytes; // whole sectors of an unaligned O_DIRECT tail, see direct_io_retry()
+    const char *p = (const char *)buf;
+    while (total < nbytes)
+    {
+        size_t len = (nbytes - total < cap) ? nbytes - total : cap;
+        ssize_t w = write(fd, p + total, len);
+        if (w < 0)
+        {
+            if (errno == EINVAL && (cap = direct_io_retry(fd, len)) > 0)
+                continue;
+            return -1;
+        }
+        total += w;
+        cap = nbytes;
+    }
+    return total;
+}
+
+// positional variant of robust_read()
+static ssize_t robust_pread(int fd, void *buf, size_t nbytes, off_t offset)
+{
+    size_t total = 0;
+    size_t cap = nbytes; // whole sectors of an unaligned O_DIRECT transfer, see direct_io_retry()
+    char *p = (char *)buf;
+    while (total < nbytes)
+    {
+        size_t len = (nbytes - total < cap) ? nbytes - total : cap;
+        ssize_t r = pread(fd, p + total, len, offset + total);
+        if (r == 0)
+            break; // EOF
+        if (r < 0)
+        {
+            if (errno == EINTR || (errno == EINVAL && (cap = direct_io_retry(fd, len)) > 0))
+                continue;
+            return (total > 0) ? total : -1;
+        }
+        total += r;
+        cap = nbytes;
+    }
+    return total;
+}
+
+// positional variant of robust_write()
+static ssize_t robust_pwrite(int fd, const void *buf, size_t nbytes, off_t offset)
+{
+    size_t total = 0;
+    size_t cap = nbytes; // whole sectors of an unaligned O_DIRECT tail, see direct_io_retry()
+    const char *p = (const char *)buf;
+    while (total < nbytes)
+    {
+        size_t len = (nbytes - total < cap) ? nbytes - total : cap;
+        ssize_t w = pwrite(fd, p + total, len, offset + total);
+        if (w < 0)
+        {
+            if (errno == EINTR || (errno == EINVAL && (cap = direct_io_retry(fd, len)) > 0))
+                continue;
+            return -1;
+        }
+        total += w;
+        cap = nbytes;
+    }
+    return total;
+}
+
+// portable zero check, one 64-bit word at a time
+static bool zero_block_generic(const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        if (word)
+            return false;
+    }
+    for (; i < len; i++)
+    {
+        if (p[i])
+            return false;
+    }
+    return true;
+}
+
+#ifdef HAVE_X86_SIMD
+// AVX2 zero check, 128 bytes per iteration
+__attribute__((target("avx2"))) static bool zero_block_avx2(const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    size_t i = 0;
+    for (; i + 128 <= len; i += 128)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(p + i + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(p + i + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(p + i + 96));
+        __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+        if (!_mm256_testz_si256(any, any))
+            return false;
+    }
+    return zero_block_generic(p + i, len - i);
+}
+
+// SSE2 zero check, 64 bytes per iteration
+__attribute__((target("sse2"))) static bool zero_block_sse2(const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + i + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(p + i + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(p + i + 48));
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, zero)) != 0xFFFF)
+            return false;
+    }
+    return zero_block_generic(p + i, len - i);
+}
+#endif
+
+#ifdef HAVE_NEON
+// NEON zero check, 64 bytes per iteration
+static bool zero_block_neon(const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64)
+    {
+        uint8x16_t any = vorrq_u8(vorrq_u8(vld1q_u8(p + i), vld1q_u8(p + i + 16)),
+                                  vorrq_u8(vld1q_u8(p + i + 32), vld1q_u8(p + i + 48)));
+        if (vmaxvq_u8(any) != 0)
+            return false;
+    }
+    return zero_block_generic(p + i, len - i);
+}
+#endif
+
+// pick the fastest zero-block check supported by this CPU
+static void init_zero_detection(void)
+{
+    is_zero_block = zero_block_generic;
+    zero_block_impl = "generic";
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        is_zero_block = zero_block_avx2;
+        zero_block_impl = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        is_zero_block = zero_block_sse2;
+        zero_block_impl = "sse2";
+    }
+#elif defined(HAVE_NEON)
+    is_zero_block = zero_block_neon;
+    zero_block_impl = "neon";
+#endif
+}
+
+// check whether positional I/O is possible on fd
+static bool is_seekable(int fd)
+{
+    return lseek(fd, 0, SEEK_CUR) != -1;
+}
+
+// check whether fd refers to a pipe or FIFO
+static bool is_pipe(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+// check whether fd refers to a regular file
+static bool is_regular(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+// drop O_DIRECT from fd so unaligned edges can be transferred, returns true if it was set
+static bool clear_direct_io(int fd)
+{
+#if HAVE_DIRECT_IO
+    int flags = fcntl(fd, F_GETFL);
+    if (flags != -1 && (flags & IO_DIRECT_FLAG))
+        return fcntl(fd, F_SETFL, flags & ~IO_DIRECT_FLAG) == 0;
+#endif
+    return false;
+}
+
+// sector size O_DIRECT transfers on fd must be multiples of: the logical sector size of a
+// block device, the block size of a file's filesystem, DIRECT_IO_ALIGN when neither is known
+static size_t direct_io_align(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_blksize > 0)
+        return (size_t)st.st_blksize;
+    DeviceTopology topo;
+    probe_topology(fd, &topo);
+    return topo.logical ? topo.logical : DIRECT_IO_ALIGN;
+}
+
+// O_DIRECT rejected a transfer of len bytes with EINVAL: returns the bytes to retry with, the
+// whole sectors of an unaligned transfer, or a final partial sector once O_DIRECT is dropped
+// for it; 0 when a misaligned offset or buffer makes the transfer fail for real
+static size_t direct_io_retry(int fd, size_t len)
+{
+    size_t align = direct_io_align(fd);
+    if (len % align != 0 && len > align)
+        return len - len % align;
+    if (len < align && clear_direct_io(fd))
+        return len;
+    return 0;
+}
+
+// return how many bytes of hole start at pos, keeping the file position unchanged
+static size_t hole_bytes_at(int fd, ExtentCursor *cursor, off_t pos)
+{
+    if (!cursor->valid || pos < cursor->data || pos >= cursor->hole)
+    {
+        off_t saved = lseek(fd, 0, SEEK_CUR);
+        off_t data = lseek(fd, pos, SEEK_DATA);
+        if (data == -1 && errno == ENXIO)
+        {
+            // only a hole remains up to EOF
+            struct stat st;
+            data = (fstat(fd, &st) == 0 && st.st_size > pos) ? st.st_size : pos;
+            cursor->hole = data;
+        }
+        else if (data == -1)
+        {
+            // SEEK_DATA unsupported: treat everything as data
+            data = pos;
+            cursor->hole = (off_t)(SIZE_MAX >> 1);
+        }
+        else
+        {
+            off_t hole = lseek(fd, data, SEEK_HOLE);
+            cursor->hole = (hole == -1) ? (off_t)(SIZE_MAX >> 1) : hole;
+        }
+        cursor->data = data;
+        cursor->valid = true;
+        if (saved != -1)
+            lseek(fd, saved, SEEK_SET);
+        errno = 0;
+        if (pos < data)
+            return data - pos;
+    }
+    return 0;
+}
+
+// count the allocated bytes of fd between start and end by walking its data extents
+static size_t allocated_bytes_in(int fd, off_t start, off_t end)
+{
+    off_t saved = lseek(fd, 0, SEEK_CUR);
+    size_t allocated = 0;
+    off_t pos = start;
+    while (pos < end)
+    {
+        off_t data = lseek(fd, pos, SEEK_DATA);
+        if (data == -1 || data >= end)
+            break;
+        off_t hole = lseek(fd, data, SEEK_HOLE);
+        if (hole == -1 || hole > end)
+            hole = end;
+        allocated += hole - data;
+        pos = hole;
+    }
+    if (saved != -1)
+        lseek(fd, saved, SEEK_SET);
+    errno = 0;
+    return allocated;
+}
+
+// leave len bytes of hole in the output at out_pos and advance its position past them
+static int write_hole(const Options *opts, ManagedResources *res, off_t out_pos, size_t len)
+{
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if (opts->holes == HOLES_PUNCH &&
+        fallocate(res->out_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, out_pos, len) == 0)
+        return lseek(res->out_fd, len, SEEK_CUR) == -1 ? -1 : 0;
+#endif
+    // a freshly truncated file only needs a seek; devices and pipes need real zeros
+    if (opts->holes != HOLES_PUNCH && is_regular(res->out_fd))
+        return lseek(res->out_fd, len, SEEK_CUR) == -1 ? -1 : 0;
+
+    size_t buffer_size = transfer_size(opts);
+    memset(res->buffer, 0, buffer_size);
+    while (len > 0)
+    {
+        size_t chunk = (len < buffer_size) ? len : buffer_size;
+        if (robust_write(res->out_fd, res->buffer, chunk) != (ssize_t)chunk)
+            return -1;
+        len -= chunk;
+    }
+    return 0;
+}
+
+// extend a regular output file to end if trailing holes were skipped
+static int finalize_output_size(int fd, off_t end)
+{
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size >= end)
+        return 0;
+    return ftruncate(fd, end);
+}
+
+// reserve len bytes of the output at offset, returns true if blocks were allocated
+static bool preallocate_output(const Options *opts, int fd, off_t offset, size_t len)
+{
+    if (opts->prealloc == PREALLOC_OFF || len == 0 || !is_regular(fd))
+        return false;
+    // preallocated blocks would defeat sparse output and shared extents
+    if (opts->holes != HOLES_OFF || (opts->conv & CONV_SPARSE) || opts->clone != CLONE_OFF)
+        return false;
+
+#ifdef HAVE_LINUX_FEATURES
+    struct statvfs vfs;
+    if (fstatvfs(fd, &vfs) == 0 && (unsigned long long)vfs.f_bavail * vfs.f_frsize < len)
+    {
+        fprintf(stderr, "warning: not enough free space to preallocate %zu bytes\n", len);
+        return false;
+    }
+
+    struct stat st;
+    int mode = (opts->prealloc == PREALLOC_KEEP_SIZE) ? FALLOC_FL_KEEP_SIZE : 0;
+    if (fstat(fd, &st) == 0 && fallocate(fd, mode, offset, len) == 0)
+        return true;
+    if (errno == ENOSPC)
+    {
+        // a failed fallocate may leave part of the range allocated, give it back
+        fprintf(stderr, "warning: cannot preallocate %zu bytes: %s\n", len, strerror(errno));
+        if (ftruncate(fd, st.st_size) == -1)
+            fprintf(stderr, "warning: cannot release partial preallocation: %s\n", strerror(errno));
+    }
+#endif
+    errno = 0; // unsupported by the filesystem, writes allocate as usual
+    return false;
+}
+
+// advance input by bytes, reading and discarding data when fd cannot seek
+static int skip_input(int fd, off_t bytes)
+{
+    if (lseek(fd, bytes, SEEK_CUR) != -1)
+        return 0;
+    if (errno != ESPIPE)
+        return -1;
+
+    char scratch[64 * 1024];
+    while (bytes > 0)
+    {
+        size_t chunk = (bytes < (off_t)sizeof(scratch)) ? (size_t)bytes : sizeof(scratch);
+        ssize_t r = robust_read(fd, scratch, chunk);
+        if (r < 0)
+            return -1;
+        if (r == 0)
+            break; // EOF before the skip offset, nothing left to copy
+        bytes -= r;
+    }
+    errno = 0;
+    return 0;
+}
+
+// blocking copy loop: read one block, then write it
+static int copy_loop_sync(const Options *opts, ManagedResources *res, CopyStats *stats,
+                          const TransferRange *range)
+{
+    stats->engine = ENGINE_SYNC;
+    if (opts->in_block_size != opts->out_block_size)
+        return copy_loop_reblock(opts, res, stats, range);
+
+    StatsShard *shard = stats->shards; // counters of this thread
+    size_t buffer_size = sync_buffer_size(opts);
+    HANDLE_ERROR(!res->buffer && !(res->buffer = allocate_aligned_buffer(buffer_size)), res,
+                 "error allocating aligned memory of size %zu", buffer_size);
+
+    WriteBehind wb;
+    write_behind_init(&wb, opts, range->out_offset, &shard->latency[LAT_SYNC]);
+    DropBehind db;
+    drop_behind_init(&db, opts, range->in_offset);
+    Autotuner tuner;
+    autotune_init(&tuner, opts, buffer_size, 1);
+    ExtentCursor extents = {.valid = false};
+    while (!stop_requested && (range->limit == 0 || shard->bytes < range->limit))
+    {
+        size_t want = tuner.dims[TUNE_BLOCK_SIZE].value;
+        if (range->limit > 0 && range->limit - shard->bytes < want)
+            want = range->limit - shard->bytes;
+
+        if (opts->holes != HOLES_OFF)
+        {
+            // skip whole blocks that lie inside an input hole
+            size_t hole = hole_bytes_at(res->in_fd, &extents, range->in_offset + shard->bytes);
+            if (range->limit > 0 && hole > range->limit - shard->bytes)
+                hole = range->limit - shard->bytes;
+            hole -= hole % opts->block_size;
+            if (hole > 0)
+            {
+                HANDLE_ERROR(lseek(res->in_fd, hole, SEEK_CUR) == -1, res, "error skipping hole");
+                HANDLE_ERROR(write_hole(opts, res, range->out_offset + shard->bytes, hole) == -1,
+                             res, "error writing hole");
+                stats_add(shard, hole, blocks_between(opts, shard->bytes, shard->bytes + hole));
+                continue;
+            }
+            // end a coalesced transfer with the block that reaches into the next hole
+            off_t data_left = extents.hole - (range->in_offset + (off_t)shard->bytes);
+            if (extents.valid && data_left > 0 && logical_blocks(opts, data_left) * opts->block_size < want)
+                want = logical_blocks(opts, data_left) * opts->block_size;
+        }
+
+        uint64_t started = monotonic_ns();
+        ssize_t bytes_read = read_blocks(res->in_fd, res->buffer, want, opts->block_size);
+        latency_record(&shard->latency[LAT_READ], started);
+        if (bytes_read == 0)
+            break; // EOF
+        HANDLE_ERROR(bytes_read < 0, res, "error reading");
+        if ((opts->conv & CONV_SPARSE) && is_zero_block(res->buffer, bytes_read))
+        {
+            HANDLE_ERROR(write_hole(opts, res, range->out_offset + shard->bytes, bytes_read) == -1,
+                         res, "error writing hole");
+            stats_add(shard, bytes_read, blocks_between(opts, shard->bytes, shard->bytes + bytes_read));
+            continue;
+        }
+        started = monotonic_ns();
+        ssize_t bytes_written = robust_write(res->out_fd, res->buffer, bytes_read);
+        latency_record(&shard->latency[LAT_WRITE], started);
+        HANDLE_ERROR(bytes_written != bytes_read, res, "error writing");
+        if (opts->fsync_flag)
+        {
+            started = monotonic_ns();
+            HANDLE_ERROR(flush_buffer(res->out_fd, true, false) == -1, res, "error syncing");
+            latency_record(&shard->latency[LAT_SYNC], started);
+        }
+        HANDLE_ERROR(write_behind_advance(&wb, res->out_fd, range->out_offset + shard->bytes + bytes_read) == -1,
+                     res, "error starting writeback");
+        drop_behind_advance(&db, res->in_fd, bytes_read);
+        autotune_advance(&tuner, bytes_read);
+
+        stats_add(shard, bytes_read, blocks_between(opts, shard->bytes, shard->bytes + bytes_read));
+    }
+    autotune_finish(&tuner, stats);
+
+    if (opts->holes != HOLES_OFF || (opts->conv & CONV_SPARSE))
+        HANDLE_ERROR(finalize_output_size(res->out_fd, range->out_offset + shard->bytes) == -1,
+                     res, "error extending output");
+    return EXIT_SUCCESS;
+}
+
+// reblocking copy loop for ibs= different from obs=: whole input blocks are appended to one
+// buffer and every complete output block in it is written, the last one possibly partial
+static int copy_loop_reblock(const Options *opts, ManagedResources *res, CopyStats *stats,
+                             const TransferRange *range)
+{
+    StatsShard *shard = stats->shards; // counters of this thread
+    size_t buffer_size = sync_buffer_size(opts);
+    HANDLE_ERROR(!res->buffer && !(res->buffer = allocate_aligned_buffer(buffer_size)), res,
+                 "error allocating aligned memory of size %zu", buffer_size);
+    char *buffer = res->buffer;
+    size_t in_size = coalesced_size(opts, opts->in_block_size);
+    size_t out_unit = coalesced_size(opts, opts->out_block_size); // a chunk of a large output block
+    if (out_unit > opts->out_block_size)
+        out_unit = opts->out_block_size;
+
+    WriteBehind wb;
+    write_behind_init(&wb, opts, range->out_offset, &shard->latency[LAT_SYNC]);
+    DropBehind db;
+    drop_behind_init(&db, opts, range->in_offset);
+    size_t consumed = 0; // input bytes read
+    size_t fill = 0;     // bytes read but not written yet
+    bool eof = false;
+    while (!eof)
+    {
+        size_t want = stop_requested ? 0 : in_size;
+        if (range->limit > 0 && range->limit - consumed < want)
+            want = range->limit - consumed;
+
+        ssize_t bytes_read = 0;
+        if (want > 0)
+        {
+            uint64_t started = monotonic_ns();
+            bytes_read = read_blocks(res->in_fd, buffer + fill, want, opts->in_block_size);
+            latency_record(&shard->latency[LAT_READ], started);
+            HANDLE_ERROR(bytes_read < 0, res, "error reading");
+            drop_behind_advance(&db, res->in_fd, bytes_read);
+        }
+        eof = (bytes_read == 0); // also the end of count= or an interrupt
+        consumed += bytes_read;
+        fill += bytes_read;
+
+        // at the end the remainder goes out as a partial output block
+        size_t len = eof ? fill : fill - fill % out_unit;
+        if (len == 0)
+            continue;
+        uint64_t started = monotonic_ns();
+        ssize_t bytes_written = robust_write(res->out_fd, buffer, len);
+        latency_record(&shard->latency[LAT_WRITE], started);
+        HANDLE_ERROR(bytes_written != (ssize_t)len, res, "error writing");
+        if (opts->fsync_flag)
+        {
+            started = monotonic_ns();
+            HANDLE_ERROR(flush_buffer(res->out_fd, true, false) == -1, res, "error syncing");
+            latency_record(&shard->latency[LAT_SYNC], started);
+        }
+        HANDLE_ERROR(write_behind_advance(&wb, res->out_fd, range->out_offset + shard->bytes + len) == -1, res,
+                     "error starting writeback");
+
+        stats_add(shard, len, blocks_between(opts, shard->bytes, shard->bytes + len));
+        fill -= len;
+        memmove(buffer, buffer + len, fill);
+    }
+    return EXIT_SUCCESS;
+}
+
+// wait for the other side of the pipeline ring to move *watch away from seen: yield a few
+// times, then sleep on the ring's condition variable, accounting the time as wait
+static void ring_wait(PipelineRing *ring, atomic_size_t *watch, size_t seen, unsigned *spins, StatsShard *shard)
+{
+    uint64_t started = monotonic_ns();
+    if (*spins < RING_SPIN_LIMIT)
+    {
+        (*spins)++;
+        sched_yield();
+    }
+    else
+    {
+        pthread_mutex_lock(&ring->lock);
+        atomic_fetch_add(&ring->sleepers, 1);
+        if (atomic_load(watch) == seen && !atomic_load(&ring->reader_done) &&
+            !atomic_load(&ring->writer_failed) && !stop_requested)
+        {
+            // a signal does not wake the condition variable, the timeout bounds the delay
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += RING_WAIT_USEC * 1000L;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&ring->progress, &ring->lock, &deadline);
+        }
+        atomic_fetch_sub(&ring->sleepers, 1);
+        pthread_mutex_unlock(&ring->lock);
+    }
+    stats_add_wait(shard, started);
+}
+
+// wake the other side of the ring after publishing head, tail or a flag, if it sleeps
+static void ring_notify(PipelineRing *ring)
+{
+    // orders the published store before the sleepers check, pairs with ring_wait()
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->sleepers, memory_order_relaxed) == 0)
+        return;
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->progress);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+// pipeline reader thread: fills ring buffers with consecutive blocks
+static void *pipeline_reader_func(void *arg)
+{
+    PipelineRing *ring = (PipelineRing *)arg;
+    const TransferRange *range = ring->range;
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t copied = 0;
+    DropBehind db;
+    drop_behind_init(&db, ring->opts, range->in_offset);
+
+    while (!stop_requested && !atomic_load_explicit(&ring->writer_failed, memory_order_relaxed) &&
+           (range->limit == 0 || copied < range->limit))
+    {
+        // wait for a free buffer
+        unsigned spins = 0;
+        while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == ring->depth)
+        {
+            if (stop_requested || atomic_load_explicit(&ring->writer_failed, memory_order_relaxed))
+                goto done;
+            ring_wait(ring, &ring->head, tail - ring->depth, &spins, ring->shard);
+        }
+
+        size_t want = transfer_size(ring->opts);
+        if (range->limit > 0 && range->limit - copied < want)
+            want = range->limit - copied;
+
+        size_t slot = tail % ring->depth;
+        uint64_t started = monotonic_ns();
+        ssize_t bytes_read = read_blocks(ring->res->in_fd, ring->res->pool[slot], want, ring->opts->block_size);
+        latency_record(&ring->shard->latency[LAT_READ], started);
+        if (bytes_read == 0)
+            break; // EOF
+        if (bytes_read < 0)
+        {
+            ring->read_errno = errno;
+            break;
+        }
+
+        ring->lengths[slot] = (size_t)bytes_read;
+        atomic_store_explicit(&ring->tail, ++tail, memory_order_release);
+        ring_notify(ring);
+        copied += (size_t)bytes_read;
+        drop_behind_advance(&db, ring->res->in_fd, bytes_read);
+    }
+done:
+    atomic_store_explicit(&ring->reader_done, true, memory_order_release);
+    ring_notify(ring);
+    return NULL;
+}
+
+// pipeline copy loop: a reader thread fills buffers while this thread writes them
+static int copy_loop_pipeline(const Options *opts, ManagedResources *res, CopyStats *stats,
+                              const TransferRange *range)
+{
+    stats->engine = ENGINE_PIPELINE;
+    StatsShard *shard = stats->shards; // counters of this thread
+    size_t depth = opts->pipeline_depth;
+    size_t buffer_size = transfer_size(opts);
+    HANDLE_ERROR(allocate_buffer_pool(res, depth, buffer_size) == -1, res,
+                 "error allocating %zu aligned buffers of size %zu", depth, buffer_size);
+
+    PipelineRing ring = {
+        .opts = opts,
+        .res = res,
+        .range = range,
+        .shard = &stats->shards[1],
+        .depth = depth};
+    __atomic_store_n(&stats->queue_capacity, depth, __ATOMIC_RELAXED);
+    atomic_init(&ring.head, 0);
+    atomic_init(&ring.tail, 0);
+    atomic_init(&ring.reader_done, false);
+    atomic_init(&ring.writer_failed, false);
+    atomic_init(&ring.sleepers, 0);
+    HANDLE_ERROR(!(ring.lengths = calloc(depth, sizeof(size_t))), res,
+                 "error allocating pipeline ring");
+    pthread_mutex_init(&ring.lock, NULL);
+    pthread_cond_init(&ring.progress, NULL);
+
+    pthread_t reader;
+    errno = pthread_create(&reader, NULL, pipeline_reader_func, &ring);
+    if (errno != 0)
+    {
+        free(ring.lengths);
+        pthread_cond_destroy(&ring.progress);
+        pthread_mutex_destroy(&ring.lock);
+        HANDLE_ERROR(true, res, "error creating reader thread");
+    }
+
+    WriteBehind wb;
+    write_behind_init(&wb, opts, range->out_offset, &shard->latency[LAT_SYNC]);
+    size_t head = 0;
+    int write_errno = 0;
+    const char *failure = NULL;
+    for (;;)
+    {
+        // wait for a filled buffer, or for the reader to finish
+        unsigned spins = 0;
+        while (head == atomic_load_explicit(&ring.tail, memory_order_acquire))
+        {
+            if (atomic_load_explicit(&ring.reader_done, memory_order_acquire) &&
+                head == atomic_load_explicit(&ring.tail, memory_order_acquire))
+                goto drained;
+            ring_wait(&ring, &ring.tail, head, &spins, shard);
+        }
+        __atomic_store_n(&shard->queue_occupancy, atomic_load_explicit(&ring.tail, memory_order_relaxed) - head,
+                         __ATOMIC_RELAXED);
+
+        size_t slot = head % depth;
+        ssize_t len = (ssize_t)ring.lengths[slot];
+        uint64_t started = monotonic_ns();
+        ssize_t written = robust_write(res->out_fd, res->pool[slot], len);
+        latency_record(&shard->latency[LAT_WRITE], started);
+        if (written != len)
+            failure = "error writing";
+        else if (opts->fsync_flag)
+        {
+            started = monotonic_ns();
+            if (flush_buffer(res->out_fd, true, false) == -1)
+                failure = "error syncing";
+            latency_record(&shard->latency[LAT_SYNC], started);
+        }
+        if (!failure && write_behind_advance(&wb, res->out_fd, range->out_offset + shard->bytes + len) == -1)
+            failure = "error starting writeback";
+        if (failure)
+        {
+            write_errno = errno;
+            atomic_store_explicit(&ring.writer_failed, true, memory_order_relaxed);
+            ring_notify(&ring);
+            break;
+        }
+
+        stats_add(shard, len, blocks_between(opts, shard->bytes, shard->bytes + len));
+        atomic_store_explicit(&ring.head, ++head, memory_order_release);
+        ring_notify(&ring);
+    }
+drained:
+    pthread_join(reader, NULL);
+    free(ring.lengths);
+    pthread_cond_destroy(&ring.progress);
+    pthread_mutex_destroy(&ring.lock);
+
+    errno = write_errno;
+    HANDLE_ERROR(failure != NULL, res, "%s", failure);
+    errno = ring.read_errno;
+    HANDLE_ERROR(ring.read_errno != 0, res, "error reading");
+    return EXIT_SUCCESS;
+}
+
+// record the first failure of a striped worker and stop the others
+static void stripe_fail(StripeWork *work, const char *failure)
+{
+    int saved_errno = errno;
+    pthread_mutex_lock(&work->failure_lock);
+    if (!work->failure)
+    {
+        work->failure = failure;
+        work->error_errno = saved_errno;
+    }
+    pthread_mutex_unlock(&work->failure_lock);
+    atomic_store(&work->failed, true);
+}
+
+// lower the EOF block index if block is earlier than the current one
+static void stripe_set_end(StripeWork *work, size_t block)
+{
+    size_t end = atomic_load(&work->end_block);
+    while (block < end && !atomic_compare_exchange_weak(&work->end_block, &end, block))
+        ;
+}
+
+// striped worker: claims stripes of blocks and copies them with pread/pwrite
+static void *stripe_worker_func(void *arg)
+{
+    StripeWorker *worker = (StripeWorker *)arg;
+    StripeWork *work = worker->work;
+    const TransferRange *range = work->range;
+    size_t block_size = transfer_size(work->opts); // a block here is one coalesced transfer
+    void *buffer = work->res->pool[worker->id];
+    StatsShard *shard = &work->stats->shards[worker->id];
+
+    for (;;)
+    {
+        // an interrupt stops new claims, but every claimed stripe is finished, so the copied
+        // bytes stay one contiguous prefix that skip= and seek= can resume from
+        if (stop_requested)
+            return NULL;
+        size_t first = atomic_fetch_add(&work->next_stripe, 1) * work->stripe_blocks;
+        for (size_t block = first; block < first + work->stripe_blocks; block++)
+        {
+            if (atomic_load_explicit(&work->failed, memory_order_relaxed) ||
+                block >= atomic_load_explicit(&work->end_block, memory_order_relaxed))
+                return NULL;
+
+            size_t offset = block * block_size;
+            if (range->limit > 0 && offset >= range->limit)
+                return NULL;
+            size_t want = block_size;
+            if (range->limit > 0 && range->limit - offset < want)
+                want = range->limit - offset;
+
+            LatencyHistogram *latency = shard->latency;
+            uint64_t started = monotonic_ns();
+            ssize_t bytes_read = robust_pread(work->res->in_fd, buffer, want, range->in_offset + offset);
+            latency_record(&latency[LAT_READ], started);
+            if (bytes_read < 0)
+            {
+                stripe_fail(work, "error reading");
+                return NULL;
+            }
+            if (bytes_read == 0)
+            {
+                stripe_set_end(work, block);
+                return NULL;
+            }
+            started = monotonic_ns();
+            ssize_t bytes_written = robust_pwrite(work->res->out_fd, buffer, bytes_read, range->out_offset + offset);
+            latency_record(&latency[LAT_WRITE], started);
+            if (bytes_written != bytes_read)
+            {
+                stripe_fail(work, "error writing");
+                return NULL;
+            }
+            if (work->opts->fsync_flag)
+            {
+                started = monotonic_ns();
+                if (flush_buffer(work->res->out_fd, true, false) == -1)
+                {
+                    stripe_fail(work, "error syncing");
+                    return NULL;
+                }
+                latency_record(&latency[LAT_SYNC], started);
+            }
+
+            stats_add(shard, (size_t)bytes_read, blocks_between(work->opts, offset, offset + bytes_read));
+            if ((size_t)bytes_read < want)
+            {
+                stripe_set_end(work, block + 1); // short read: EOF inside this block
+                return NULL;
+            }
+        }
+    }
+}
+
+// striped copy loop: jobs workers copy interleaved stripes with positional I/O
+static int copy_loop_jobs(const Options *opts, ManagedResources *res, CopyStats *stats,
+                          const TransferRange *range)
+{
+    stats->engine = ENGINE_JOBS;
+    if (!is_seekable(res->in_fd) || !is_seekable(res->out_fd))
+    {
+        fprintf(stderr, "warning: jobs= needs seekable input and output, using sync engine\n");
+        return copy_loop_sync(opts, res, stats, range);
+    }
+    // stripes start at multiples of the transfer size, O_DIRECT rejects any that are not whole sectors
+    size_t transfer = transfer_size(opts);
+    if (uses_direct_io(opts) &&
+        (transfer % direct_io_align(res->in_fd) != 0 || transfer % direct_io_align(res->out_fd) != 0))
+    {
+        fprintf(stderr, "warning: jobs= needs sector-aligned transfers for direct I/O, using sync engine\n");
+        return copy_loop_sync(opts, res, stats, range);
+    }
+
+    size_t jobs = opts->jobs;
+    size_t buffer_size = transfer_size(opts);
+    HANDLE_ERROR(allocate_buffer_pool(res, jobs, buffer_size) == -1, res,
+                 "error allocating %zu aligned buffers of size %zu", jobs, buffer_size);
+
+    StripeWork work = {
+        .opts = opts,
+        .res = res,
+        .range = range,
+        .stats = stats,
+        .stripe_blocks = (buffer_size < STRIPE_SIZE) ? STRIPE_SIZE / buffer_size : 1,
+        .failure = NULL};
+    atomic_init(&work.next_stripe, 0);
+    atomic_init(&work.end_block, SIZE_MAX);
+    atomic_init(&work.failed, false);
+    pthread_mutex_init(&work.failure_lock, NULL);
+
+    StripeWorker workers[MAX_JOBS];
+    pthread_t threads[MAX_JOBS];
+    size_t started = 1; // worker 0 runs on this thread
+    for (size_t i = 0; i < jobs; i++)
+    {
+        workers[i] = (StripeWorker){.work = &work, .id = i};
+        if (i > 0 && pthread_create(&threads[i], NULL, stripe_worker_func, &workers[i]) == 0)
+            started++;
+        else if (i > 0)
+            break; // run with the workers we have
+    }
+
+    stripe_worker_func(&workers[0]);
+    for (size_t i = 1; i < started; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&work.failure_lock);
+
+    errno = work.error_errno;
+    HANDLE_ERROR(work.failure != NULL, res, "%s", work.failure);
+    return EXIT_SUCCESS;
+}
+
+#if HAVE_SPLICE
+// grow a pipe buffer so each splice() can move a whole block
+static void enlarge_pipe(int fd, size_t block_size)
+{
+    int size = (block_size > SPLICE_PIPE_SIZE) ? (int)block_size : SPLICE_PIPE_SIZE;
+    if (fcntl(fd, F_GETPIPE_SZ) >= size)
+        return;
+    // unprivileged users are capped by /proc/sys/fs/pipe-max-size, keep the default then
+    while (size > SPLICE_PIPE_SIZE / 16 && fcntl(fd, F_SETPIPE_SZ, size) == -1)
+        size /= 2;
+}
+
+// splice copy loop: moves pages between a pipe and the other endpoint inside the kernel
+static int copy_loop_splice(const Options *opts, ManagedResources *res, CopyStats *stats,
+                            const TransferRange *range)
+{
+    stats->engine = ENGINE_SPLICE;
+    StatsShard *shard = stats->shards; // counters of this thread
+    bool in_pipe = is_pipe(res->in_fd);
+    bool out_pipe = is_pipe(res->out_fd);
+    if (!in_pipe && !out_pipe)
+    {
+        fprintf(stderr, "warning: splice engine needs a pipe endpoint, using sync engine\n");
+        return copy_loop_sync(opts, res, stats, range);
+    }
+    if (in_pipe)
+        enlarge_pipe(res->in_fd, opts->block_size);
+    if (out_pipe)
+        enlarge_pipe(res->out_fd, opts->block_size);
+
+    WriteBehind wb;
+    write_behind_init(&wb, opts, range->out_offset, &shard->latency[LAT_SYNC]);
+    DropBehind db;
+    drop_behind_init(&db, opts, range->in_offset);
+
+    while (!stop_requested && (range->limit == 0 || shard->bytes < range->limit))
+    {
+        size_t want = transfer_size(opts);
+        if (range->limit > 0 && range->limit - shard->bytes < want)
+            want = range->limit - shard->bytes;
+
+        size_t moved = 0;
+        uint64_t started = monotonic_ns();
+        while (moved < want)
+        {
+            ssize_t n = splice(res->in_fd, NULL, res->out_fd, NULL, want - moved,
+                               SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (n == 0)
+                break; // EOF
+            if (n > 0)
+            {
+                moved += n;
+                if (in_pipe && moved < want && moved % opts->block_size == 0)
+                    break; // the pipe is drained, hand on the complete blocks like read_blocks()
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            if (shard->bytes == 0 && moved == 0 && (errno == EINVAL || errno == ENOSYS))
+            {
+                // endpoint does not support splice (e.g. O_APPEND or a special file)
+                errno = 0;
+                return copy_loop_sync(opts, res, stats, range);
+            }
+            HANDLE_ERROR(true, res, "error splicing");
+        }
+        if (moved == 0)
+            break; // EOF
+        latency_record(&shard->latency[LAT_WRITE], started);
+        if (opts->fsync_flag)
+        {
+            started = monotonic_ns();
+            HANDLE_ERROR(flush_buffer(res->out_fd, true, false) == -1, res, "error syncing");
+            latency_record(&shard->latency[LAT_SYNC], started);
+        }
+        HANDLE_ERROR(write_behind_advance(&wb, res->out_fd, range->out_offset + shard->bytes + moved) == -1, res,
+                     "error starting writeback");
+        drop_behind_advance(&db, res->in_fd, moved);
+
+        stats_add(shard, moved, blocks_between(opts, shard->bytes, shard->bytes + moved));
+        if (moved < want && moved % opts->block_size != 0)
+            break; // EOF inside this block
+    }
+    return EXIT_SUCCESS;
+}
+#endif
+
+#if HAVE_COPY_FILE_RANGE
+// copy_file_range loop: the kernel (or the filesystem) copies each block without user buffers
+static int copy_loop_copy_range(const Options *opts, ManagedResources *res, CopyStats *stats,
+                                const TransferRange *range)
+{
+    stats->engine = ENGINE_COPY_RANGE;
+    StatsShard *shard = stats->shards; // counters of this thread
+    loff_t in_off = range->in_offset;
+    loff_t out_off = range->out_offset;
+    WriteBehind wb;
+    write_behind_init(&wb, opts, range->out_offset, &shard->latency[LAT_SYNC]);
+    DropBehind db;
+    drop_behind_init(&db, opts, range->in_offset);
+
+    while (!stop_requested && (range->limit == 0 || shard->bytes < range->limit))
+    {
+        size_t want = transfer_size(opts);
+        if (range->limit > 0 && range->limit - shard->bytes < want)
+            want = range->limit - shard->bytes;
+
+        size_t moved = 0;
+        uint64_t started = monotonic_ns();
+        while (moved < want)
+        {
+            ssize_t n = copy_file_range(res->in_fd, &in_off, res->out_fd, &out_off, want - moved, 0);
+            if (n == 0)
+                break; // EOF
+            if (n > 0)
+            {
+                moved += n;
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            if (moved == 0 && (errno == EXDEV || errno == EOPNOTSUPP || errno == ENOSYS || errno == EINVAL))
+            {
+                // not offloadable here: continue from the same offsets with the buffered loop
+                HANDLE_ERROR(lseek(res->in_fd, in_off, SEEK_SET) == -1 ||
+                                 lseek(res->out_fd, out_off, SEEK_SET) == -1,
+                             res, "error seeking for buffered fallback");
+                errno = 0;
+                return copy_loop_sync(opts, res, stats, range);
+            }
+            HANDLE_ERROR(true, res, "error copying range");
+        }
+        if (moved == 0)
+            break; // EOF
+        latency_record(&shard->latency[LAT_WRITE], started);
+        if (opts->fsync_flag)
+        {
+            started = monotonic_ns();
+            HANDLE_ERROR(flush_buffer(res->out_fd, true, false) == -1, res, "error syncing");
+            latency_record(&shard->latency[LAT_SYNC], started);
+        }
+        HANDLE_ERROR(write_behind_advance(&wb, res->out_fd, range->out_offset + shard->bytes + moved) == -1, res,
+                     "error starting writeback");
+        drop_behind_advance(&db, res->in_fd, moved);
+
+        stats_add(shard, moved, blocks_between(opts, shard->bytes, shard->bytes + moved));
+        if (moved < want)
+            break; // EOF inside this block
+    }
+    return EXIT_SUCCESS;
+}
+#endif
+
+// copy len bytes between explicit offsets through res->buffer, returns bytes copied or -1
+static ssize_t copy_range_buffered(const Options *opts, ManagedResources *res,
+                                   off_t in_off, off_t out_off, size_t len)
+{
+    if (len == 0)
+        return 0;
+    if (!res->buffer && !(res->buffer = allocate_aligned_buffer(sync_buffer_size(opts))))
+        return -1;
+    if (uses_direct_io(opts))
+    {
+        // edges of a clone are not sector aligned
+        clear_direct_io(res->in_fd);
+        clear_direct_io(res->out_fd);
+    }
+
+    size_t copied = 0;
+    size_t buffer_size = transfer_size(opts);
+    while (copied < len)
+    {
+        size_t chunk = (len - copied < buffer_size) ? len - copied : buffer_size;
+        ssize_t n = robust_pread(res->in_fd, res->buffer, chunk, in_off + copied);
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break; // EOF
+        if (robust_pwrite(res->out_fd, res->buffer, n, out_off + copied) != n)
+            return -1;
+        copied += n;
+    }
+    return copied;
+}
+
+// clone the block-aligned bulk of the range with FICLONERANGE and copy the unaligned edges,
+// returns false if the normal copy engines should handle the range instead
+static bool clone_file_range(const Options *opts, ManagedResources *res, CopyStats *stats,
+                             const TransferRange *range)
+{
+    if (opts->clone == CLONE_OFF)
+        return false;
+#if HAVE_CLONE_RANGE
+    bool always = (opts->clone == CLONE_ALWAYS);
+    StatsShard *shard = stats->shards;
+    struct stat in_st, out_st;
+    if (fstat(res->in_fd, &in_st) == -1 || fstat(res->out_fd, &out_st) == -1 ||
+        !S_ISREG(in_st.st_mode) || !S_ISREG(out_st.st_mode))
+    {
+        errno = 0;
+        HANDLE_ERROR(always, res, "clone=always needs regular input and output files");
+        return false;
+    }
+    if (range->in_offset >= in_st.st_size)
+        return false; // nothing to clone
+
+    size_t len = in_st.st_size - range->in_offset;
+    if (range->limit > 0 && range->limit < len)
+        len = range->limit;
+
+    // extents can only be shared when both offsets sit at the same place within a block
+    size_t align = (out_st.st_blksize > 0) ? (size_t)out_st.st_blksize : 4096;
+    if (range->in_offset % align != range->out_offset % align)
+    {
+        errno = 0;
+        HANDLE_ERROR(always, res, "clone=always needs skip and seek offsets with equal alignment to %zu bytes",
+                     align);
+        return false;
+    }
+
+    size_t head = (align - range->in_offset % align) % align;
+    if (head > len)
+        head = len;
+    size_t bulk = (len - head) / align * align;
+
+    size_t cloned = 0;
+    while (cloned < bulk && !stop_requested)
+    {
+        size_t chunk = (bulk - cloned < CLONE_CHUNK_SIZE) ? bulk - cloned : CLONE_CHUNK_SIZE;
+        struct file_clone_range fcr = {
+            .src_fd = res->in_fd,
+            .src_offset = range->in_offset + head + cloned,
+            .src_length = chunk,
+            .dest_offset = range->out_offset + head + cloned};
+        if (ioctl(res->out_fd, FICLONERANGE, &fcr) == -1)
+        {
+            HANDLE_ERROR(always || cloned > 0, res, "error cloning range");
+            errno = 0;
+            return false; // filesystem cannot share extents, use the copy engines
+        }
+        cloned += chunk;
+        __atomic_store_n(&shard->bytes_cloned, shard->bytes_cloned + chunk, __ATOMIC_RELAXED);
+        stats_add(shard, chunk, blocks_between(opts, shard->bytes, shard->bytes + chunk));
+    }
+
+    ssize_t edge = copy_range_buffered(opts, res, range->in_offset, range->out_offset, head);
+    HANDLE_ERROR(edge < 0, res, "error copying unaligned head");
+    stats_add(shard, edge, blocks_between(opts, shard->bytes, shard->bytes + edge));
+    if (!stop_requested && cloned == bulk)
+    {
+        size_t done = head + bulk;
+        edge = copy_range_buffered(opts, res, range->in_offset + done, range->out_offset + done, len - done);
+        HANDLE_ERROR(edge < 0, res, "error copying unaligned tail");
+        stats_add(shard, edge, blocks_between(opts, shard->bytes, shard->bytes + edge));
+    }
+    // the records report splits the bytes into full and partial blocks, see count_records()
+    return true;
+#else
+    return false;
+#endif
+}
+
+// resolve engine=auto from the endpoint types
+static CopyEngine select_engine(const Options *opts, const ManagedResources *res)
+{
+    if (opts->in_block_size != opts->out_block_size)
+    {
+        // records are reblocked in the sync loop only
+        if (opts->engine != ENGINE_AUTO && opts->engine != ENGINE_SYNC)
+            fprintf(stderr, "warning: different ibs= and obs= use the sync engine instead of %s\n",
+                    ENGINE_STRINGS[opts->engine]);
+        return ENGINE_SYNC;
+    }
+    if (opts->holes != HOLES_OFF || (opts->conv & CONV_SPARSE))
+    {
+        // extents and zero blocks are handled by the sync loop only
+        if (opts->engine != ENGINE_AUTO && opts->engine != ENGINE_SYNC)
+            fprintf(stderr, "warning: holes= and conv=sparse use the sync engine instead of %s\n",
+                    ENGINE_STRINGS[opts->engine]);
+        return ENGINE_SYNC;
+    }
+    if (opts->engine != ENGINE_AUTO)
+        return opts->engine;
+    // bs=auto can only tune transfers the copy loop issues itself
+    if (opts->auto_block_size)
+        return ENGINE_SYNC;
+#if HAVE_SPLICE
+    // O_DIRECT pages cannot be moved through a pipe, keep those on the buffered path
+    if (!uses_direct_io(opts) && (is_pipe(res->in_fd) || is_pipe(res->out_fd)))
+        return ENGINE_SPLICE;
+#endif
+#if HAVE_COPY_FILE_RANGE
+    if (!uses_direct_io(opts) && is_regular(res->in_fd) && is_regular(res->out_fd))
+        return ENGINE_COPY_RANGE;
+#endif
+    return ENGINE_SYNC;
+}
+
+#if HAVE_IO_URING
+// set up an io_uring instance with at least the given number of entries
+static int uring_init(IoUring *ring, unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0)
+        return -1;
+    if (!uring_probe(ring->fd))
+    {
+        uring_destroy(ring);
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+    {
+        if (ring->cq_ring_size > ring->sq_ring_size)
+            ring->sq_ring_size = ring->cq_ring_size;
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED)
+    {
+        ring->sq_ring = NULL;
+        uring_destroy(ring);
+        return -1;
+    }
+
+    if (single_mmap)
+        ring->cq_ring = ring->sq_ring;
+    else
+    {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED)
+        {
+            ring->cq_ring = NULL;
+            uring_destroy(ring);
+            return -1;
+        }
+    }
+
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        ring->sqes = NULL;
+        uring_destroy(ring);
+        return -1;
+    }
+
+    char *sq = ring->sq_ring;
+    char *cq = ring->cq_ring;
+    ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+// unmap the rings and close the io_uring file descriptor
+static void uring_destroy(IoUring *ring)
+{
+    if (ring->sqes)
+        munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring)
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->fd >= 0)
+        close(ring->fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+// check that the kernel behind ring_fd implements every opcode the copy loops queue,
+// io_uring_setup() alone succeeds on kernels (or seccomp filters) that reject them
+static bool uring_probe(int ring_fd)
+{
+    static const int opcodes[] = {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_FSYNC};
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    if (!probe)
+        return false;
+    bool supported = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (size_t i = 0; supported && i < sizeof(opcodes) / sizeof(opcodes[0]); i++)
+        supported = opcodes[i] <= probe->last_op && (probe->ops[opcodes[i]].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return supported;
+}
+
+// queue a single read/write/fsync request tagged with user_data, submitting the queued
+// requests first when the submission queue is full
+static int uring_queue(IoUring *ring, int opcode, int fd, void *buf, size_t len,
+                       off_t offset, uint64_t user_data)
+{
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring->sq_tail;
+    if (tail - head > *ring->sq_mask)
+    {
+        if (uring_submit(ring, 0) == -1)
+            return -1;
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head > *ring->sq_mask)
+        {
+            errno = EBUSY; // submission queue still full
+            return -1;
+        }
+    }
+
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (uint8_t)opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = (uint32_t)len;
+    sqe->off = (uint64_t)offset;
+    sqe->user_data = user_data;
+    if (opcode == IORING_OP_FSYNC)
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->pending++;
+    return 0;
+}
+
+// submit queued requests and wait for at least wait_nr completions
+static int uring_submit(IoUring *ring, unsigned wait_nr)
+{
+    for (;;)
+    {
+        int r = (int)syscall(__NR_io_uring_enter, ring->fd, ring->pending, wait_nr,
+                             wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (r >= 0)
+        {
+            ring->pending -= (unsigned)r;
+            return r;
+        }
+        if (errno != EINTR)
+            return -1;
+    }
+}
+
+// return the next completion, or NULL if none is ready
+static struct io_uring_cqe *uring_peek(IoUring *ring)
+{
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+// release the completion returned by uring_peek()
+static void uring_cqe_seen(IoUring *ring)
+{
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+typedef enum
+{
+    SLOT_FREE,  // buffer available for a new read
+    SLOT_READ,  // read in flight
+    SLOT_WRITE, // write in flight
+    SLOT_SYNC   // fdatasync in flight
+} UringSlotState;
+
+typedef struct
+{
+    UringSlotState state; // current stage of this buffer
+    off_t offset;         // block offset relative to the start of the range
+    size_t want;          // bytes requested for this block
+    size_t done;          // bytes completed in the current stage
+    size_t len;           // bytes held in the buffer after the read
+    uint64_t started;     // monotonic time the current stage was first queued
+} UringSlot;
+
+// queue the next request for a slot according to its current stage, -1 if it cannot be queued
+static int uring_queue_slot(IoUring *ring, const ManagedResources *res, const TransferRange *range,
+                            const UringSlot *slot, size_t i)
+{
+    char *buf = res->pool[i];
+    switch (slot->state)
+    {
+    case SLOT_READ:
+        return uring_queue(ring, IORING_OP_READ, res->in_fd, buf + slot->done, slot->want - slot->done,
+                           range->in_offset + slot->offset + slot->done, i);
+    case SLOT_WRITE:
+        return uring_queue(ring, IORING_OP_WRITE, res->out_fd, buf + slot->done, slot->len - slot->done,
+                           range->out_offset + slot->offset + slot->done, i);
+    case SLOT_SYNC:
+        return uring_queue(ring, IORING_OP_FSYNC, res->out_fd, NULL, 0, 0, i);
+    case SLOT_FREE:
+        break;
+    }
+    return 0;
+}
+
+// end of the completed prefix of the range: blocks complete out of order, so it is the
+// offset of the first slot still in flight, or next when none is
+static off_t uring_completed_end(const UringSlot *slots, size_t depth, size_t next)
+{
+    off_t end = (off_t)next;
+    for (size_t i = 0; i < depth; i++)
+        if (slots[i].state != SLOT_FREE && slots[i].offset < end)
+            end = slots[i].offset;
+    return end;
+}
+
+// io_uring copy loop: keeps up to queue_depth blocks in flight
+static int copy_loop_uring(const Options *opts, ManagedResources *res, CopyStats *stats,
+                           const TransferRange *range)
+{
+    stats->engine = ENGINE_URING;
+    StatsShard *shard = stats->shards; // counters of this thread
+    if (!is_seekable(res->in_fd) || !is_seekable(res->out_fd))
+    {
+        fprintf(stderr, "warning: io_uring engine needs seekable input and output, using sync engine\n");
+        return copy_loop_sync(opts, res, stats, range);
+    }
+
+    size_t depth = opts->queue_depth;
+    HANDLE_ERROR(!(res->ring = malloc(sizeof(IoUring))), res, "error allocating io_uring");
+    if (uring_init(res->ring, (unsigned)depth) == -1)
+    {
+        fprintf(stderr, "warning: io_uring unavailable (%s), using sync engine\n", strerror(errno));
+        free(res->ring);
+        res->ring = NULL;
+        return copy_loop_sync(opts, res, stats, range);
+    }
+    // bs=auto may grow transfers as long as the whole queue stays within the in-flight budget
+    size_t buffer_size = transfer_size(opts);
+    if (opts->auto_block_size && depth * buffer_size < MAX_AUTO_INFLIGHT)
+    {
+        buffer_size = MAX_AUTO_INFLIGHT / depth;
+        if (buffer_size > MAX_AUTO_BLOCK_SIZE)
+            buffer_size = MAX_AUTO_BLOCK_SIZE;
+        if (buffer_size < opts->block_size)
+            buffer_size = opts->block_size;
+        if (buffer_size > chunk_limit(opts))
+            buffer_size = chunk_limit(opts);
+    }
+    HANDLE_ERROR(allocate_buffer_pool(res, depth, buffer_size) == -1, res,
+                 "error allocating %zu aligned buffers of size %zu", depth, buffer_size);
+
+    IoUring *ring = res->ring;
+    __atomic_store_n(&stats->queue_capacity, depth, __ATOMIC_RELAXED);
+    UringSlot slots[MAX_QUEUE_DEPTH];
+    memset(slots, 0, sizeof(slots));
+    size_t next = 0;
+    size_t inflight = 0;
+    bool eof = false;
+    WriteBehind wb; // windows follow the completed prefix, see uring_completed_end()
+    write_behind_init(&wb, opts, range->out_offset, &shard->latency[LAT_SYNC]);
+    DropBehind db;
+    drop_behind_init(&db, opts, range->in_offset);
+    Autotuner tuner;
+    autotune_init(&tuner, opts, buffer_size, depth);
+
+    for (;;)
+    {
+        // start reads into every free buffer the tuned queue depth allows
+        size_t active_depth = tuner.dims[TUNE_QUEUE_DEPTH].value;
+        for (size_t i = 0; i < active_depth && !stop_requested && !eof; i++)
+        {
+            if (slots[i].state != SLOT_FREE)
+                continue;
+            if (range->limit > 0 && next >= range->limit)
+                break;
+
+            size_t want = tuner.dims[TUNE_BLOCK_SIZE].value;
+            if (range->limit > 0 && range->limit - next < want)
+                want = range->limit - next;
+
+            slots[i] = (UringSlot){.state = SLOT_READ, .offset = (off_t)next, .want = want,
+                                   .started = monotonic_ns()};
+            HANDLE_ERROR(uring_queue_slot(ring, res, range, &slots[i], i) == -1, res,
+                         "error queueing io_uring request");
+            next += want;
+            inflight++;
+        }
+        if (inflight == 0)
+            break;
+
+        __atomic_store_n(&shard->queue_occupancy, inflight, __ATOMIC_RELAXED);
+        uint64_t waited = monotonic_ns();
+        HANDLE_ERROR(uring_submit(ring, 1) == -1, res, "error submitting io_uring requests");
+        stats_add_wait(shard, waited);
+
+        struct io_uring_cqe *cqe;
+        while ((cqe = uring_peek(ring)) != NULL)
+        {
+            size_t i = (size_t)cqe->user_data;
+            int r = cqe->res;
+            uring_cqe_seen(ring);
+
+            UringSlot *slot = &slots[i];
+            if (r == -EINVAL && slot->state == SLOT_WRITE &&
+                (slot->len - slot->done) % direct_io_align(res->out_fd) != 0)
+            {
+                // unaligned final block: robust_pwrite() writes its whole sectors direct, the rest buffered
+                size_t left = slot->len - slot->done;
+                ssize_t w = robust_pwrite(res->out_fd, (char *)res->pool[i] + slot->done, left,
+                                          range->out_offset + slot->offset + slot->done);
+                r = (w == (ssize_t)left) ? (int)left : -errno;
+            }
+            else if (r == -EINVAL && slot->state == SLOT_READ &&
+                     (slot->want - slot->done) % direct_io_align(res->in_fd) != 0)
+            {
+                // unaligned block size: robust_pread() reads the whole sectors direct, the rest buffered
+                ssize_t n = robust_pread(res->in_fd, (char *)res->pool[i] + slot->done, slot->want - slot->done,
+                                         range->in_offset + slot->offset + slot->done);
+                r = (n >= 0) ? (int)n : -errno;
+            }
+            if (r == -EINTR || r == -EAGAIN)
+            {
+                HANDLE_ERROR(uring_queue_slot(ring, res, range, slot, i) == -1, res,
+                             "error queueing io_uring request");
+                continue;
+            }
+            if (r < 0)
+                errno = -r;
+
+            bool complete = false;
+            switch (slot->state)
+            {
+            case SLOT_READ:
+                HANDLE_ERROR(r < 0 && slot->done == 0, res, "error reading");
+                if (r > 0)
+                {
+                    slot->done += r;
+                    if (slot->done < slot->want)
+                    {
+                        HANDLE_ERROR(uring_queue_slot(ring, res, range, slot, i) == -1, res,
+                                     "error queueing io_uring request");
+                        break;
+                    }
+                }
+                else
+                    eof = true; // EOF, or an error after a partial block like robust_read()
+
+                latency_record(&shard->latency[LAT_READ], slot->started);
+                if (slot->done == 0)
+                {
+                    slot->state = SLOT_FREE;
+                    inflight--;
+                    break;
+                }
+                slot->len = slot->done;
+                slot->done = 0;
+                slot->state = SLOT_WRITE;
+                slot->started = monotonic_ns();
+                HANDLE_ERROR(uring_queue_slot(ring, res, range, slot, i) == -1, res,
+                             "error queueing io_uring request");
+                break;
+
+            case SLOT_WRITE:
+                HANDLE_ERROR(r <= 0, res, "error writing");
+                slot->done += r;
+                if (slot->done < slot->len)
+                {
+                    HANDLE_ERROR(uring_queue_slot(ring, res, range, slot, i) == -1, res,
+                                 "error queueing io_uring request");
+                    break;
+                }
+                latency_record(&shard->latency[LAT_WRITE], slot->started);
+                if (opts->fsync_flag)
+                {
+                    slot->state = SLOT_SYNC;
+                    slot->started = monotonic_ns();
+                    HANDLE_ERROR(uring_queue_slot(ring, res, range, slot, i) == -1, res,
+                                 "error queueing io_uring request");
+                }
+                else
+                    complete = true;
+                break;
+
+            case SLOT_SYNC:
+                HANDLE_ERROR(r < 0, res, "error syncing");
+                latency_record(&shard->latency[LAT_SYNC], slot->started);
+                complete = true;
+                break;
+
+            case SLOT_FREE:
+                break;
+            }
+
+            if (complete)
+            {
+                slot->state = SLOT_FREE;
+                HANDLE_ERROR(write_behind_advance(&wb, res->out_fd,
+                                                  range->out_offset + uring_completed_end(slots, depth, next)) == -1,
+                             res, "error starting writeback");
+                drop_behind_advance(&db, res->in_fd, slot->len);
+                autotune_advance(&tuner, slot->len);
+                stats_add(shard, slot->len, blocks_between(opts, slot->offset, slot->offset + slot->len));
+                inflight--;
+            }
+        }
+    }
+    autotune_finish(&tuner, stats);
+    return EXIT_SUCCESS;
+}
+#endif
+
+// copy data from input file to output file
+static int copy_file(Options *opts)
+{
+    ManagedResources res;
+    managed_resources_init(&res);
+
+    FileHandler in_file = {
+        .path = opts->if_path,
+        .is_input = true};
+    FileHandler out_file = {
+        .path = opts->of_path,
+        .is_input = false};
+    // one statistics shard per thread that copies: jobs= workers, or pipeline writer and reader
+    CopyStats stats;
+    HANDLE_ERROR(init_copy_stats(&stats, opts->jobs > 2 ? opts->jobs : 2) == -1, &res,
+                 "error allocating copy statistics");
+    res.stats = &stats;
+
+    HANDLE_ERROR(open_file(&in_file, opts) == -1 || open_file(&out_file, opts) == -1, &res,
+                 "error opening input file '%s' or output file '%s'", opts->if_path, opts->of_path);
+    res.in_fd = in_file.fd;
+    res.out_fd = out_file.fd;
+
+    DeviceTopology in_topo, out_topo;
+    probe_topology(res.in_fd, &in_topo);
+    probe_topology(res.out_fd, &out_topo);
+
+    // settings tuned by an earlier bs=auto run on the same devices replace the topology guess
+    TuningEntry tuning = {.engine = ENGINE_AUTO};
+    bool tunable = device_key(res.in_fd, tuning.in_key, sizeof(tuning.in_key)) &&
+                   device_key(res.out_fd, tuning.out_key, sizeof(tuning.out_key));
+    TuningEntry cached;
+    size_t auto_block_size, auto_depth;
+    if (opts->block_size == 0 && tunable && tuning_cache_lookup(&tuning, &cached))
+    {
+        auto_block_size = cached.block_size;
+        auto_depth = cached.queue_depth;
+        // bs=auto never compares engines, so its engine is only where it resumes tuning,
+        // plain copies keep engine=auto's own choice (e.g. copy_file_range)
+        opts->resume_tuning = opts->auto_block_size;
+        if (opts->auto_block_size && opts->engine == ENGINE_AUTO && opts->holes == HOLES_OFF &&
+            !(opts->conv & CONV_SPARSE) && (cached.engine == ENGINE_SYNC || cached.engine == ENGINE_URING))
+            opts->engine = cached.engine;
+    }
+    else
+        auto_block_size = optimize_block_size(&in_topo, &out_topo, &auto_depth);
+
+    // cache and topology only size transfers: without bs= (or with bs=auto) the blocks that
+    // count=, skip= and seek= refer to stay DEFAULT_BLOCK_SIZE on every host, as with dd
+    if (opts->block_size == 0)
+    {
+        opts->block_size = DEFAULT_BLOCK_SIZE;
+        opts->transfer_hint = auto_block_size;
+    }
+    if (opts->queue_depth == 0)
+        opts->queue_depth = auto_depth;
+
+    // ibs= and obs= default to bs, the engines then move whole output blocks
+    if (opts->in_block_size == 0)
+        opts->in_block_size = opts->block_size;
+    if (opts->out_block_size == 0)
+        opts->out_block_size = opts->block_size;
+    opts->block_size = opts->out_block_size;
+#if HAVE_DIRECT_IO
+    // check if block size is appropriate for direct I/O, unaligned transfers end up buffered
+    if ((opts->iflags & IO_FLAG_DIRECT) && opts->in_block_size % direct_io_align(res.in_fd) != 0)
+        fprintf(stderr, "warning: block size %zu is not a multiple of %zu for direct I/O\n",
+                opts->in_block_size, direct_io_align(res.in_fd));
+    else if ((opts->oflags & IO_FLAG_DIRECT) && opts->out_block_size % direct_io_align(res.out_fd) != 0)
+        fprintf(stderr, "warning: block size %zu is not a multiple of %zu for direct I/O\n",
+                opts->out_block_size, direct_io_align(res.out_fd));
+#endif
+    if (chunk_limit(opts) < CHUNK_ALIGN)
+    {
+        errno = 0;
+        HANDLE_ERROR(true, &res, "maxmem=%zu cannot hold %zu buffers of %d bytes",
+                     opts->max_memory, buffer_count(opts), CHUNK_ALIGN);
+    }
+
+    // skip= and count= are in input blocks, seek= in output blocks, unless the matching *_bytes flag is set
+    off_t skip_bytes = (opts->iflags & IO_FLAG_SKIP_BYTES) ? opts->skip : opts->skip * (off_t)opts->in_block_size;
+    off_t seek_bytes = (opts->oflags & IO_FLAG_SEEK_BYTES) ? opts->seek : opts->seek * (off_t)opts->out_block_size;
+
+    if (skip_bytes > 0)
+        HANDLE_ERROR(skip_input(res.in_fd, skip_bytes) == -1,
+                     &res, "error skipping input blocks");
+    if (seek_bytes > 0)
+        HANDLE_ERROR(lseek(res.out_fd, seek_bytes, SEEK_SET) == -1,
+                     &res, "error seeking output blocks");
+
+    TransferRange range = {
+        .in_offset = is_seekable(res.in_fd) ? lseek(res.in_fd, 0, SEEK_CUR) : 0,
+        .out_offset = is_seekable(res.out_fd) ? lseek(res.out_fd, 0, SEEK_CUR) : 0,
+        .limit = (opts->iflags & IO_FLAG_COUNT_BYTES) ? opts->count : opts->count * opts->in_block_size};
+
+    size_t total_bytes = 0;
+    struct stat in_st;
+    if (fstat(res.in_fd, &in_st) == 0 && S_ISREG(in_st.st_mode))
+        total_bytes = (in_st.st_size > range.in_offset) ? in_st.st_size - range.in_offset : 0;
+    else if (in_topo.size > 0)
+        total_bytes = (in_topo.size > (uint64_t)range.in_offset) ? in_topo.size - range.in_offset : 0;
+    if (opts->count > 0 && (total_bytes == 0 || range.limit < total_bytes))
+        total_bytes = range.limit;
+
+    bool preallocated = preallocate_output(opts, res.out_fd, range.out_offset, total_bytes);
+    if (preallocated && opts->prealloc == PREALLOC_AUTO)
+        res.prealloc_offset = range.out_offset; // error_exit() trims what the copy did not fill
+#if HAVE_FADVISE && defined(POSIX_FADV_NOREUSE)
+    // hint that the data is touched once, on kernels that act on it
+    if (opts->iflags & IO_FLAG_NOCACHE)
+        posix_fadvise(res.in_fd, range.in_offset, 0, POSIX_FADV_NOREUSE);
+    if (opts->oflags & IO_FLAG_NOCACHE)
+        posix_fadvise(res.out_fd, range.out_offset, 0, POSIX_FADV_NOREUSE);
+#endif
+
+    ProgressThreadData thread_data;
+    init_progress_thread_data(&thread_data, &stats, total_bytes);
+    if (opts->holes != HOLES_OFF && total_bytes > 0 && is_regular(res.in_fd))
+        thread_data.allocated_bytes = allocated_bytes_in(res.in_fd, range.in_offset,
+                                                         range.in_offset + total_bytes);
+    if (opts->metrics_path)
+    {
+        res.metrics_fd = open_metrics_socket(opts->metrics_path);
+        HANDLE_ERROR(res.metrics_fd == -1, &res, "error listening on metrics socket '%s'", opts->metrics_path);
+        res.metrics_path = opts->metrics_path;
+        thread_data.metrics_fd = res.metrics_fd;
+    }
+    // the bar goes to stderr and only to a terminal, never into the data stream or a log
+    thread_data.show_progress = (opts->status == STATUS_PROGRESS || opts->status == STATUS_NOXFER) &&
+                                isatty(STDERR_FILENO);
+
+    // without a progress thread SIGUSR1 stays blocked and pending, status=none prints nothing
+    pthread_t progress_thread;
+    bool thread_active = false;
+    if (opts->status != STATUS_NONE || res.metrics_fd >= 0)
+        thread_active = (pthread_create(&progress_thread, NULL, progress_thread_func, &thread_data) == 0);
+
+    // a successful clone covers the whole range, otherwise copy it with an engine
+    if (!clone_file_range(opts, &res, &stats, &range))
+    {
+        opts->engine = select_engine(opts, &res);
+        if (opts->auto_block_size && opts->engine != ENGINE_SYNC && opts->engine != ENGINE_URING)
+            fprintf(stderr, "note: bs=auto has no effect with engine=%s, transfers stay %zu bytes\n",
+                    ENGINE_STRINGS[opts->engine], transfer_size(opts));
+        switch (opts->engine)
+        {
+#if HAVE_SPLICE
+        case ENGINE_SPLICE:
+            copy_loop_splice(opts, &res, &stats, &range);
+            break;
+#endif
+#if HAVE_COPY_FILE_RANGE
+        case ENGINE_COPY_RANGE:
+            copy_loop_copy_range(opts, &res, &stats, &range);
+            break;
+#endif
+        case ENGINE_PIPELINE:
+            copy_loop_pipeline(opts, &res, &stats, &range);
+            break;
+        case ENGINE_JOBS:
+            copy_loop_jobs(opts, &res, &stats, &range);
+            break;
+#if HAVE_IO_URING
+        case ENGINE_URING:
+            copy_loop_uring(opts, &res, &stats, &range);
+            break;
+#endif
+        default:
+            copy_loop_sync(opts, &res, &stats, &range);
+            break;
+        }
+        opts->engine = stats.engine; // report and remember the engine that actually ran
+    }
+
+    // one data sync makes the write-behind windows durable and lets nocache drop the rest
+    if (opts->sync_window > 0 || (opts->oflags & IO_FLAG_NOCACHE))
+    {
+        uint64_t started = monotonic_ns();
+        HANDLE_ERROR(flush_buffer(res.out_fd, true, (opts->oflags & IO_FLAG_NOCACHE) != 0) == -1,
+                     &res, "error syncing");
+        latency_record(&stats.shards[0].latency[LAT_SYNC], started);
+    }
+
+    // all copy threads are done, the totals are final apart from the clock
+    StatsSnapshot final;
+    stats_snapshot(&stats, &final, true);
+    final.tuned_block_size = stats.tuned_block_size;
+    final.tuned_queue_depth = stats.tuned_queue_depth;
+    final.tuned_rate = stats.tuned_rate;
+    if (opts->iflags & IO_FLAG_NOCACHE)
+        drop_cached_range(res.in_fd, range.in_offset, final.total_bytes_copied);
+
+    // drop the preallocated size the copy did not fill (short input or interruption)
+    if (preallocated && opts->prealloc == PREALLOC_AUTO)
+    {
+        struct stat st;
+        off_t end = range.out_offset + final.total_bytes_copied;
+        if (fstat(res.out_fd, &st) == 0 && st.st_size > end)
+            HANDLE_ERROR(ftruncate(res.out_fd, end) == -1, &res, "error trimming preallocated output");
+        res.prealloc_offset = -1;
+    }
+
+    finish_progress_thread(&thread_data, progress_thread, thread_active);
+    res.stats = NULL;
+    free_copy_stats(&stats);
+
+    // the report must not end up in the data stream when writing to stdout
+    FILE *report = strcmp(opts->of_path, "-") == 0 ? stderr : stdout;
+    if (opts->status == STATUS_JSON)
+        print_json_report(report, opts, &final);
+    else if (opts->status != STATUS_NONE)
+    {
+        size_t full, partial;
+        count_records(&final, opts->in_block_size, &full, &partial);
+        fprintf(report, "%zu+%zu records in\n", full, partial);
+        count_records(&final, opts->out_block_size, &full, &partial);
+        fprintf(report, "%zu+%zu records out\n", full, partial);
+    }
+    if (opts->status == STATUS_PROGRESS)
+    {
+        double speed_mb_per_second = 0.0;
+        if (final.elapsed_time > 0.001) // at least 1ms
+            speed_mb_per_second = (double)final.total_bytes_copied / MEGABYTE / final.elapsed_time;
+        else
+            speed_mb_per_second = 9999.99; // assume 10GB/s for very fast systems
+
+        fprintf(report, "%.2f %s copied, %.2f seconds, %.2f MB/s\n",
+                (double)final.total_bytes_copied / MEGABYTE,
+                "MB", final.elapsed_time, speed_mb_per_second);
+        if (final.tuned_block_size > 0)
+            fprintf(report, "bs=auto settled on transfers of %zu bytes, qd=%zu\n", final.tuned_block_size,
+                    final.tuned_queue_depth);
+        print_latency_report(report, &final);
+        if (opts->clone != CLONE_OFF)
+            fprintf(report, "%.2f MB cloned, %.2f MB copied\n",
+                    (double)final.bytes_cloned / MEGABYTE,
+                    (double)(final.total_bytes_copied - final.bytes_cloned) / MEGABYTE);
+    }
+
+    // remember what bs=auto measured so later runs on these devices start there
+    if (tunable && !stop_requested && final.tuned_rate > 0)
+    {
+        tuning.block_size = final.tuned_block_size;
+        tuning.queue_depth = final.tuned_queue_depth;
+        tuning.engine = opts->engine;
+        tuning.rate = final.tuned_rate / MEGABYTE;
+        tuning_cache_store(&tuning);
+    }
+
+    managed_resources_destroy(&res);
+    return EXIT_SUCCESS;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// turn the raw counters of one configuration into rates and latency percentiles
+static void bench_summarize(BenchResult *result, double *lat, size_t samples, size_t ops,
+                            size_t bytes, double elapsed)
+{
+    result->rate = elapsed > 0 ? bytes / elapsed : 0;
+    result->iops = elapsed > 0 ? ops / elapsed : 0;
+    result->lat_avg = result->lat_p99 = 0;
+    if (samples == 0)
+        return;
+
+    double sum = 0;
+    for (size_t i = 0; i < samples; i++)
+        sum += lat[i];
+    qsort(lat, samples, sizeof(double), compare_doubles);
+    result->lat_avg = sum / samples * 1e6;
+    result->lat_p99 = lat[(size_t)((samples - 1) * 0.99)] * 1e6;
+}
+
+// sequential pread/pwrite over the region, the path the sync engine takes
+static int bench_sync(int fd, char *buf, off_t size, BenchResult *result, double *lat)
+{
+    size_t bs = result->block_size;
+    size_t ops = 0, samples = 0, bytes = 0;
+    off_t offset = 0;
+    double start = monotonic_seconds();
+    double now = start;
+
+    while (!stop_requested && now - start < BENCH_POINT_USEC / 1e6 && bytes < BENCH_PASSES * (size_t)size)
     {
-        ssize_t r = read(fd, p + total, nbytes - total);
-        if (r == 0)
-            break; // EOF
-        if (r < 0)
-            return (total > 0) ? total : -1;
-        total += r;
+        ssize_t r = result->write ? robust_pwrite(fd, buf, bs, offset) : robust_pread(fd, buf, bs, offset);
+        if (r <= 0)
+            return -1;
+        double done = monotonic_seconds();
+        if (samples < BENCH_MAX_SAMPLES)
+            lat[samples++] = done - now;
+        now = done;
+        ops++;
+        bytes += r;
+        offset = (offset + (off_t)(2 * bs) > size) ? 0 : offset + (off_t)bs;
     }
-    return total;
+    if (result->write && fdatasync(fd) == -1 && errno != EINVAL)
+        return -1;
+
+    bench_summarize(result, lat, samples, ops, bytes, monotonic_seconds() - start);
+    return 0;
 }
 
-// ensure all bytes are written or an error occurs
-static ssize_t robust_write(int fd, const void *buf, size_t nbytes)
+#if HAVE_IO_URING
+// sequential reads or writes with queue_depth requests in flight through io_uring
+static int bench_uring(int fd, char **bufs, off_t size, BenchResult *result, double *lat)
 {
-    size_t total = 0;
-    const char *p = (const char *)buf;
-    while (total < nbytes)
+    size_t bs = result->block_size;
+    size_t qd = result->queue_depth;
+    IoUring ring;
+    if (uring_init(&ring, (unsigned)qd) == -1)
+        return -1;
+
+    int opcode = result->write ? IORING_OP_WRITE : IORING_OP_READ;
+    double issued[MAX_QUEUE_DEPTH];
+    off_t offsets[MAX_QUEUE_DEPTH];
+    size_t ops = 0, samples = 0, bytes = 0, inflight = 0;
+    off_t next = 0;
+    double start = monotonic_seconds();
+    int rc = 0;
+
+    for (size_t i = 0; i < qd; i++)
     {
-        ssize_t w = write(fd, p + total, nbytes - total);
-        if (w < 0)
+        offsets[i] = next;
+        issued[i] = start;
+        if (uring_queue(&ring, opcode, fd, bufs[i], bs, next, i) == -1)
+        {
+            uring_destroy(&ring);
             return -1;
-        total += w;
+        }
+        next = (next + (off_t)(2 * bs) > size) ? 0 : next + (off_t)bs;
+        inflight++;
     }
-    return total;
+
+    bool draining = false;
+    while (inflight > 0)
+    {
+        if (uring_submit(&ring, 1) == -1)
+        {
+            rc = -1;
+            break;
+        }
+
+        struct io_uring_cqe *cqe;
+        while ((cqe = uring_peek(&ring)) != NULL)
+        {
+            size_t i = (size_t)cqe->user_data;
+            int r = cqe->res;
+            uring_cqe_seen(&ring);
+
+            double now = monotonic_seconds();
+            if ((r == -EINTR || r == -EAGAIN) && uring_queue(&ring, opcode, fd, bufs[i], bs, offsets[i], i) == 0)
+                continue;
+            inflight--;
+            if (r <= 0)
+            {
+                errno = r < 0 ? -r : EIO;
+                rc = -1;
+                draining = true;
+                continue;
+            }
+
+            if (samples < BENCH_MAX_SAMPLES)
+                lat[samples++] = now - issued[i];
+            ops++;
+            bytes += r;
+
+            draining = draining || stop_requested || now - start >= BENCH_POINT_USEC / 1e6 ||
+                       bytes >= BENCH_PASSES * (size_t)size;
+            if (!draining)
+            {
+                offsets[i] = next;
+                issued[i] = now;
+                if (uring_queue(&ring, opcode, fd, bufs[i], bs, next, i) == -1)
+                {
+                    rc = -1;
+                    draining = true;
+                    continue;
+                }
+                next = (next + (off_t)(2 * bs) > size) ? 0 : next + (off_t)bs;
+                inflight++;
+            }
+        }
+    }
+    uring_destroy(&ring);
+    if (rc == 0 && result->write && fdatasync(fd) == -1 && errno != EINVAL)
+        rc = -1;
+
+    if (rc == 0)
+        bench_summarize(result, lat, samples, ops, bytes, monotonic_seconds() - start);
+    return rc;
 }
+#endif
 
-// copy data from input file to output file
-static int copy_file(Options *opts)
+// measure one configuration with freshly allocated aligned buffers
+static int bench_point(int fd, bool direct, off_t size, BenchResult *result, double *lat)
 {
-    ManagedResources res;
-    managed_resources_init(&res);
+    size_t qd = result->queue_depth;
+    char *bufs[MAX_QUEUE_DEPTH];
+    size_t allocated = 0;
+    int rc = -1;
 
-    FileHandler in_file = {
-        .path = opts->if_path,
-        .is_input = true};
-    FileHandler out_file = {
-        .path = opts->of_path,
-        .is_input = false};
-    CopyStats stats;
-    init_copy_stats(&stats);
+    for (; allocated < qd; allocated++)
+    {
+        if (!(bufs[allocated] = allocate_aligned_buffer(result->block_size)))
+            goto out;
+        for (size_t j = 0; j < result->block_size; j++)
+            bufs[allocated][j] = (char)(j * 31 + allocated); // incompressible enough for a device
+    }
 
-    HANDLE_ERROR(open_file(&in_file, opts) == -1 || open_file(&out_file, opts) == -1, &res,
-                 "error opening input file '%s' or output file '%s'", opts->if_path, opts->of_path);
-    res.in_fd = in_file.fd;
-    res.out_fd = out_file.fd;
+    // buffered reads would only measure the page cache
+    if (!result->write && !direct)
+        drop_cached_range(fd, 0, 0);
 
-    if (opts->block_size == 0)
-        opts->block_size = optimize_block_size(res.in_fd);
+    if (qd == 1)
+        rc = bench_sync(fd, bufs[0], size, result, lat);
+#if HAVE_IO_URING
+    else
+        rc = bench_uring(fd, bufs, size, result, lat);
+#endif
 
-    HANDLE_ERROR(!(res.buffer = allocate_aligned_buffer(opts->block_size)), &res,
-                 "error allocating aligned memory of size %zu", opts->block_size);
+out:
+    for (size_t i = 0; i < allocated; i++)
+        free_aligned_buffer(bufs[i]);
+    return rc;
+}
 
-    if (opts->skip > 0)
-        HANDLE_ERROR(lseek(res.in_fd, opts->skip * opts->block_size, SEEK_SET) == -1,
-                     &res, "error skipping input blocks");
-    if (opts->seek > 0)
-        HANDLE_ERROR(lseek(res.out_fd, opts->seek * opts->block_size, SEEK_SET) == -1,
-                     &res, "error seeking output blocks");
+// pick the cheapest configuration within BENCH_GOOD_ENOUGH of the best rate
+static const BenchResult *bench_recommend(const BenchResult *results, size_t count, bool write)
+{
+    double best_rate = 0;
+    for (size_t i = 0; i < count; i++)
+        if (results[i].write == write && results[i].rate > best_rate)
+            best_rate = results[i].rate;
 
-    size_t total_bytes = 0;
-    if (opts->count > 0)
-        total_bytes = opts->count * opts->block_size;
-    else if (res.in_fd != STDIN_FILENO)
+    const BenchResult *pick = NULL;
+    for (size_t i = 0; i < count; i++)
     {
-        struct stat st;
-        if (fstat(res.in_fd, &st) == 0 && S_ISREG(st.st_mode))
-            total_bytes = st.st_size;
+        const BenchResult *r = &results[i];
+        if (r->write != write || r->rate < best_rate * BENCH_GOOD_ENOUGH)
+            continue;
+        size_t cost = r->block_size * r->queue_depth;
+        if (!pick || cost < pick->block_size * pick->queue_depth ||
+            (cost == pick->block_size * pick->queue_depth && r->queue_depth < pick->queue_depth))
+            pick = r;
     }
+    return pick;
+}
 
-    ProgressThreadData thread_data;
-    init_progress_thread_data(&thread_data, &stats, total_bytes);
-    pthread_t progress_thread;
-    int thread_result = pthread_create(&progress_thread, NULL, progress_thread_func, &thread_data);
-    bool thread_active = (thread_result == 0);
+// sweep block sizes and queue depths for sequential reads and writes
+static int run_bench(const Options *opts)
+{
+    struct stat st;
+    char scratch[4096];
+    bool use_scratch = false;
+    off_t size = opts->bench_size ? (off_t)opts->bench_size : BENCH_DEFAULT_SIZE;
+    ManagedResources res;
+    managed_resources_init(&res);
+    int fd;
 
-    // main copy loop
-    while (!stop_requested && (opts->count == 0 || stats.blocks_copied < opts->count))
-    {
-        ssize_t bytes_read = robust_read(res.in_fd, res.buffer, opts->block_size);
-        if (bytes_read == 0)
-            break; // EOF
-        HANDLE_ERROR(bytes_read < 0, &res, "error reading");
-        ssize_t bytes_written = robust_write(res.out_fd, res.buffer, bytes_read);
-        HANDLE_ERROR(bytes_written != bytes_read, &res, "error writing");
-        if (opts->fsync_flag)
-            HANDLE_ERROR(flush_buffer(res.out_fd, true) == -1, &res, "error syncing");
+    HANDLE_ERROR(stat(opts->bench_path, &st) == -1, &res, "cannot benchmark '%s'", opts->bench_path);
 
-        stats.total_bytes_copied += bytes_read;
-        stats.blocks_copied++;
+    if (S_ISDIR(st.st_mode))
+    {
+        // a private scratch file is the only target that is safe to write
+        snprintf(scratch, sizeof(scratch), "%s/.pdd-bench-XXXXXX", opts->bench_path);
+        fd = res.out_fd = mkstemp(scratch);
+        HANDLE_ERROR(fd == -1, &res, "cannot create scratch file in '%s'", opts->bench_path);
+        unlink(scratch);
+        use_scratch = true;
     }
+    else
+    {
+        // existing files and devices are only ever read
+        fd = res.in_fd = open(opts->bench_path, O_RDONLY);
+        HANDLE_ERROR(fd == -1, &res, "cannot open '%s'", opts->bench_path);
+        DeviceTopology topo;
+        probe_topology(fd, &topo);
+        off_t available = S_ISREG(st.st_mode) ? st.st_size : (off_t)topo.size;
+        if (available < size)
+            size = available;
+    }
+    size -= size % BENCH_BLOCK_SIZES[0];
+    if (size < (off_t)BENCH_BLOCK_SIZES[0])
+    {
+        errno = 0;
+        HANDLE_ERROR(true, &res, "'%s' is too small to benchmark", opts->bench_path);
+    }
+
+    // measure what real copies with O_DIRECT see, falling back to dropping the page cache
+    bool direct = false;
+#if HAVE_DIRECT_IO
+    int flags = fcntl(fd, F_GETFL);
+    direct = flags != -1 && fcntl(fd, F_SETFL, flags | IO_DIRECT_FLAG) == 0;
+#endif
 
-    if (thread_active)
+    if (use_scratch)
     {
-        atomic_store(&thread_data.copy_finished, true);
-        pthread_join(progress_thread, NULL);
+        HANDLE_ERROR(!(res.buffer = allocate_aligned_buffer(MEGABYTE)), &res,
+                     "error allocating aligned memory of size %d", MEGABYTE);
+        memset(res.buffer, 0xa5, MEGABYTE);
+        for (off_t off = 0; off < size && !stop_requested; off += MEGABYTE)
+        {
+            size_t chunk = (size - off < MEGABYTE) ? (size_t)(size - off) : MEGABYTE;
+            HANDLE_ERROR(robust_pwrite(fd, res.buffer, chunk, off) != (ssize_t)chunk, &res,
+                         "error filling scratch file");
+        }
+        HANDLE_ERROR(fdatasync(fd) == -1 && errno != EINVAL, &res, "error syncing scratch file");
     }
 
-    printf("\n%zu+0 records in\n", stats.blocks_copied);
-    printf("%zu+0 records out\n", stats.blocks_copied);
     char size_str[32];
-    format_size(size_str, sizeof(size_str), stats.total_bytes_copied);
-    update_copy_stats(&stats);
-    double speed_mb_per_second = 0.0;
-    if (stats.elapsed_time > 0.001) // at least 1ms
-        speed_mb_per_second = (double)stats.total_bytes_copied / MEGABYTE / stats.elapsed_time;
-    else
-        speed_mb_per_second = 9999.99; // assume 10GB/s for very fast systems
+    format_size(size_str, sizeof(size_str), (double)size);
+    printf("pdd bench: %s (%s, %s, %s)\n", opts->bench_path, use_scratch ? "scratch file" : "read only",
+           size_str, direct ? "direct I/O" : "buffered, cache dropped before reads");
+    printf("%-6s %8s %4s %10s %10s %10s %10s\n", "mode", "bs", "qd", "MB/s", "IOPS", "avg us", "p99 us");
+
+    size_t nbs = sizeof(BENCH_BLOCK_SIZES) / sizeof(BENCH_BLOCK_SIZES[0]);
+    size_t nqd = sizeof(BENCH_QUEUE_DEPTHS) / sizeof(BENCH_QUEUE_DEPTHS[0]);
+    BenchResult *results = calloc(2 * nbs * nqd, sizeof(BenchResult));
+    double *lat = malloc(BENCH_MAX_SAMPLES * sizeof(double));
+    if (!results || !lat)
+    {
+        free(results);
+        free(lat);
+        HANDLE_ERROR(true, &res, "error allocating bench results");
+    }
+    size_t count = 0;
+    bool uring_ok = HAVE_IO_URING;
+
+    // writes first so the reads that follow do not find the data in a device cache
+    for (int pass = use_scratch ? 0 : 1; pass < 2 && !stop_requested; pass++)
+    {
+        for (size_t b = 0; b < nbs && !stop_requested; b++)
+        {
+            for (size_t q = 0; q < nqd && !stop_requested; q++)
+            {
+                BenchResult *r = &results[count];
+                *r = (BenchResult){.write = pass == 0,
+                                   .block_size = BENCH_BLOCK_SIZES[b],
+                                   .queue_depth = BENCH_QUEUE_DEPTHS[q]};
+                if ((off_t)r->block_size > size || r->block_size * r->queue_depth > MAX_AUTO_INFLIGHT ||
+                    (r->queue_depth > 1 && !uring_ok))
+                    continue;
+                if (bench_point(fd, direct, size, r, lat) == -1)
+                {
+                    if (r->queue_depth > 1)
+                    {
+                        fprintf(stderr, "warning: io_uring unavailable (%s), measuring qd=1 only\n",
+                                strerror(errno));
+                        uring_ok = false;
+                        continue;
+                    }
+                    const char *what = r->write ? "writes" : "reads";
+                    free(lat);
+                    free(results);
+                    HANDLE_ERROR(true, &res, "error benchmarking %s", what);
+                }
+                printf("%-6s %7zuK %4zu %10.2f %10.0f %10.1f %10.1f\n", r->write ? "write" : "read",
+                       r->block_size / 1024, r->queue_depth, r->rate / MEGABYTE, r->iops, r->lat_avg,
+                       r->lat_p99);
+                fflush(stdout);
+                count++;
+            }
+        }
+    }
 
-    printf("%.2f %s copied, %.2f seconds, %.2f MB/s\n",
-           (double)stats.total_bytes_copied / MEGABYTE,
-           "MB", stats.elapsed_time, speed_mb_per_second);
+    for (int write = 0; write < 2; write++)
+    {
+        const BenchResult *pick = bench_recommend(results, count, write);
+        if (pick)
+            printf("Recommended for %s: bs=%zuK qd=%zu engine=%s (%.2f MB/s)\n", write ? "writes" : "reads",
+                   pick->block_size / 1024, pick->queue_depth, pick->queue_depth > 1 ? "uring" : "sync",
+                   pick->rate / MEGABYTE);
+    }
 
+    free(lat);
+    free(results);
     managed_resources_destroy(&res);
-    return EXIT_SUCCESS;
+    return stop_requested ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 // option handlers
@@ -618,14 +4546,38 @@ static void handle_of(Options *opts, const char *value)
     opts->of_path = value;
 }
 
-static void handle_bs(Options *opts, const char *value)
+// parse the value of bs=, ibs= or obs=
+static size_t parse_block_size(const char *value)
 {
-    opts->block_size = parse_size(value);
-    if (opts->block_size == 0 || opts->block_size > MAX_BLOCK_SIZE)
+    size_t size = value ? parse_size(value) : 0;
+    if (size == 0 || size > MAX_BLOCK_SIZE)
     {
-        fprintf(stderr, "error: invalid block size: %s\n", value);
+        fprintf(stderr, "error: invalid block size: %s\n", value ? value : "");
         exit(EXIT_FAILURE);
     }
+    return size;
+}
+
+static void handle_bs(Options *opts, const char *value)
+{
+    // bs=auto keeps the default block size and tunes the transfer size from the topology guess
+    opts->auto_block_size = value && strcmp(value, "auto") == 0;
+    if (opts->auto_block_size)
+    {
+        opts->block_size = 0;
+        return;
+    }
+    opts->block_size = parse_block_size(value);
+}
+
+static void handle_ibs(Options *opts, const char *value)
+{
+    opts->in_block_size = parse_block_size(value);
+}
+
+static void handle_obs(Options *opts, const char *value)
+{
+    opts->out_block_size = parse_block_size(value);
 }
 
 static void handle_count(Options *opts, const char *value)
@@ -658,10 +4610,185 @@ static void handle_fsync(Options *opts, const char *value)
     opts->fsync_flag = true;
 }
 
+static void handle_engine(Options *opts, const char *value)
+{
+    for (int i = 0; i < ENGINE_COUNT; i++)
+    {
+        if (value && strcmp(value, ENGINE_STRINGS[i]) == 0)
+        {
+            opts->engine = (CopyEngine)i;
+            return;
+        }
+    }
+    fprintf(stderr, "error: unknown engine: %s\n", value ? value : "");
+    exit(EXIT_FAILURE);
+}
+
+static void handle_qd(Options *opts, const char *value)
+{
+    opts->queue_depth = value ? parse_size(value) : 0;
+    if (opts->queue_depth == 0 || opts->queue_depth > MAX_QUEUE_DEPTH)
+    {
+        fprintf(stderr, "error: invalid queue depth: %s (1-%d)\n", value ? value : "", MAX_QUEUE_DEPTH);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void handle_pipeline(Options *opts, const char *value)
+{
+    opts->pipeline_depth = value ? parse_size(value) : 0;
+    if (opts->pipeline_depth < 2 || opts->pipeline_depth > MAX_PIPELINE_DEPTH)
+    {
+        fprintf(stderr, "error: invalid pipeline depth: %s (2-%d)\n", value ? value : "", MAX_PIPELINE_DEPTH);
+        exit(EXIT_FAILURE);
+    }
+    opts->engine = ENGINE_PIPELINE;
+}
+
+static void handle_threads(Options *opts, const char *value)
+{
+    size_t threads = value ? parse_size(value) : 0;
+    if (threads == 1)
+        opts->engine = ENGINE_AUTO;
+    else if (threads == 2)
+        opts->engine = ENGINE_PIPELINE;
+    else
+    {
+        fprintf(stderr, "error: invalid thread count: %s (1 or 2)\n", value ? value : "");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void handle_jobs(Options *opts, const char *value)
+{
+    opts->jobs = value ? parse_size(value) : 0;
+    if (opts->jobs == 0 || opts->jobs > MAX_JOBS)
+    {
+        fprintf(stderr, "error: invalid number of jobs: %s (1-%d)\n", value ? value : "", MAX_JOBS);
+        exit(EXIT_FAILURE);
+    }
+    opts->engine = (opts->jobs > 1) ? ENGINE_JOBS : ENGINE_AUTO;
+}
+
+static void handle_clone(Options *opts, const char *value)
+{
+    for (int i = 0; i < CLONE_COUNT; i++)
+    {
+        if (value && strcmp(value, CLONE_STRINGS[i]) == 0)
+        {
+            opts->clone = (CloneMode)i;
+            return;
+        }
+    }
+    fprintf(stderr, "error: unknown clone mode: %s\n", value ? value : "");
+    exit(EXIT_FAILURE);
+}
+
+static void handle_holes(Options *opts, const char *value)
+{
+    for (int i = 0; i < HOLES_COUNT; i++)
+    {
+        if (value && strcmp(value, HOLE_STRINGS[i]) == 0)
+        {
+            opts->holes = (HoleMode)i;
+            return;
+        }
+    }
+    fprintf(stderr, "error: unknown holes mode: %s\n", value ? value : "");
+    exit(EXIT_FAILURE);
+}
+
+static void handle_conv(Options *opts, const char *value)
+{
+    opts->conv |= parse_flag_list(value, CONV_FLAGS, "conv");
+}
+
+static void handle_prealloc(Options *opts, const char *value)
+{
+    for (int i = 0; i < PREALLOC_COUNT; i++)
+    {
+        if (value && strcmp(value, PREALLOC_STRINGS[i]) == 0)
+        {
+            opts->prealloc = (PreallocMode)i;
+            return;
+        }
+    }
+    fprintf(stderr, "error: unknown prealloc mode: %s\n", value ? value : "");
+    exit(EXIT_FAILURE);
+}
+
+static void handle_syncwin(Options *opts, const char *value)
+{
+    opts->sync_window = value ? parse_size(value) : 0;
+    if (opts->sync_window == 0)
+    {
+        fprintf(stderr, "error: invalid sync window: %s\n", value ? value : "");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void handle_iflag(Options *opts, const char *value)
+{
+    opts->iflags |= parse_flag_list(value, IFLAG_NAMES, "iflag");
+}
+
+static void handle_oflag(Options *opts, const char *value)
+{
+    opts->oflags |= parse_flag_list(value, OFLAG_NAMES, "oflag");
+}
+
 static void handle_platform(Options *opts, const char *value)
 {
-    print_platform_info();
-    exit(EXIT_SUCCESS);
+    opts->show_platform = true;
+}
+
+static void handle_bench(Options *opts, const char *value)
+{
+    opts->bench_path = (value && *value) ? value : ".";
+}
+
+static void handle_status(Options *opts, const char *value)
+{
+    for (int i = 0; i < STATUS_COUNT; i++)
+    {
+        if (value && strcmp(value, STATUS_STRINGS[i]) == 0)
+        {
+            opts->status = (StatusMode)i;
+            return;
+        }
+    }
+    fprintf(stderr, "error: unknown status: %s\n", value ? value : "");
+    exit(EXIT_FAILURE);
+}
+
+static void handle_metrics(Options *opts, const char *value)
+{
+    if (!value || !*value)
+    {
+        fprintf(stderr, "error: metrics needs a socket path\n");
+        exit(EXIT_FAILURE);
+    }
+    opts->metrics_path = value;
+}
+
+static void handle_maxmem(Options *opts, const char *value)
+{
+    opts->max_memory = value ? parse_size(value) : 0;
+    if (opts->max_memory == 0)
+    {
+        fprintf(stderr, "error: invalid memory budget: %s\n", value ? value : "");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void handle_benchsize(Options *opts, const char *value)
+{
+    opts->bench_size = value ? parse_size(value) : 0;
+    if (opts->bench_size == 0)
+    {
+        fprintf(stderr, "error: invalid bench size: %s\n", value ? value : "");
+        exit(EXIT_FAILURE);
+    }
 }
 
 // option handler table
@@ -669,13 +4796,32 @@ static const OptionHandler option_handlers[] = {
     {"if", handle_if},
     {"of", handle_of},
     {"bs", handle_bs},
+    {"ibs", handle_ibs},
+    {"obs", handle_obs},
     {"count", handle_count},
     {"skip", handle_skip},
     {"seek", handle_seek},
     {"sync", handle_sync},
     {"direct", handle_direct},
     {"fsync", handle_fsync},
+    {"engine", handle_engine},
+    {"qd", handle_qd},
+    {"pipeline", handle_pipeline},
+    {"threads", handle_threads},
+    {"jobs", handle_jobs},
+    {"clone", handle_clone},
+    {"holes", handle_holes},
+    {"conv", handle_conv},
+    {"prealloc", handle_prealloc},
+    {"syncwin", handle_syncwin},
+    {"iflag", handle_iflag},
+    {"oflag", handle_oflag},
     {"platform", handle_platform},
+    {"bench", handle_bench},
+    {"benchsize", handle_benchsize},
+    {"status", handle_status},
+    {"metrics", handle_metrics},
+    {"maxmem", handle_maxmem},
     {NULL, NULL}}; // mark end of table
 
 // parse a command-line option
@@ -703,27 +4849,59 @@ static int parse_option(Options *opts, const char *arg)
 // validate options for consistency and correctness
 static void validate_options(Options *opts)
 {
-    if (opts->block_size == 0)
+    // the standalone flags are shorthands for per-side flags
+    if (opts->direct_flag)
     {
-        fprintf(stderr, "error: block size cannot be zero\n");
-        exit(EXIT_FAILURE);
+        opts->iflags |= IO_FLAG_DIRECT;
+        opts->oflags |= IO_FLAG_DIRECT;
     }
+    if (opts->sync_flag)
+        opts->oflags |= IO_FLAG_SYNC;
 
-#if HAVE_DIRECT_IO
-    if (opts->direct_flag)
+    // bs= overrides ibs= and obs= as in dd
+    if (opts->block_size > 0 || opts->auto_block_size)
+        opts->in_block_size = opts->out_block_size = 0;
+    if (opts->in_block_size != opts->out_block_size && (opts->holes != HOLES_OFF || (opts->conv & CONV_SPARSE)))
     {
-        // check if block size is appropriate for direct I/O
-        if ((opts->block_size % 512) != 0)
-        {
-            fprintf(stderr, "warning: block size %zu is not a multiple of 512 for direct I/O\n",
-                    opts->block_size);
-        }
+        fprintf(stderr, "error: different ibs= and obs= cannot be combined with holes= or conv=sparse\n");
+        exit(EXIT_FAILURE);
     }
-#else
-    if (opts->direct_flag)
+
+#if !HAVE_DIRECT_IO
+    if (uses_direct_io(opts))
     {
         fprintf(stderr, "warning: direct I/O is not supported on this platform, ignoring direct flag\n");
-        opts->direct_flag = false;
+        opts->iflags &= ~IO_FLAG_DIRECT;
+        opts->oflags &= ~IO_FLAG_DIRECT;
+    }
+#endif
+
+#if !HAVE_IO_URING
+    if (opts->engine == ENGINE_URING)
+    {
+        fprintf(stderr, "warning: io_uring is not supported on this platform, using sync engine\n");
+        opts->engine = ENGINE_SYNC;
+    }
+#endif
+#if !HAVE_COPY_FILE_RANGE
+    if (opts->engine == ENGINE_COPY_RANGE)
+    {
+        fprintf(stderr, "warning: copy_file_range is not supported on this platform, using sync engine\n");
+        opts->engine = ENGINE_SYNC;
+    }
+#endif
+#if !HAVE_CLONE_RANGE
+    if (opts->clone != CLONE_OFF)
+    {
+        fprintf(stderr, "warning: reflink cloning is not supported on this platform, ignoring clone\n");
+        opts->clone = CLONE_OFF;
+    }
+#endif
+#if !HAVE_SPLICE
+    if (opts->engine == ENGINE_SPLICE)
+    {
+        fprintf(stderr, "warning: splice is not supported on this platform, using sync engine\n");
+        opts->engine = ENGINE_SYNC;
     }
 #endif
 
@@ -743,19 +4921,50 @@ static void print_usage(const char *program_name)
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  if=FILE        read from FILE instead of stdin\n");
     fprintf(stderr, "  of=FILE        write to FILE instead of stdout\n");
-    fprintf(stderr, "  bs=N           read and write N bytes at a time\n");
+    fprintf(stderr, "  bs=N           read and write N bytes at a time (default: %d; transfers are sized\n",
+            DEFAULT_BLOCK_SIZE);
+    fprintf(stderr, "                 from the device topology)\n");
+    fprintf(stderr, "  bs=auto        keep tuning the transfer size (and qd with uring) while copying, and\n");
+    fprintf(stderr, "                 remember the result for these devices in $XDG_CACHE_HOME/pdd\n");
+    fprintf(stderr, "  ibs=N, obs=N   read N bytes / write N bytes at a time, reblocking between them\n");
+    fprintf(stderr, "                 (default: bs; bs= overrides both)\n");
+    fprintf(stderr, "  maxmem=SIZE    cap the I/O buffers of the copy at SIZE bytes in total, large blocks\n");
+    fprintf(stderr, "                 are moved in smaller chunks (blocks above 8M always are)\n");
     fprintf(stderr, "  count=N        copy only N input blocks\n");
     fprintf(stderr, "  skip=N         skip N input blocks at start\n");
     fprintf(stderr, "  seek=N         skip N output blocks at start\n");
     fprintf(stderr, "  sync           use synchronized I/O for data\n");
     fprintf(stderr, "  direct         use direct I/O (if supported)\n");
     fprintf(stderr, "  fsync          perform fsync after each write\n");
-    fprintf(stderr, "  platform       show platform-specific capabilities\n");
+    fprintf(stderr, "  engine=NAME    copy engine: auto (default), sync, uring, pipeline, jobs, splice,\n");
+    fprintf(stderr, "                 copy_file_range\n");
+    fprintf(stderr, "  qd=N           keep N I/Os in flight with async engines (default: from device\n");
+    fprintf(stderr, "                 topology, %d otherwise)\n", DEFAULT_QUEUE_DEPTH);
+    fprintf(stderr, "  pipeline=N     overlap reads and writes on two threads with N buffers\n");
+    fprintf(stderr, "  threads=N      1 = single-threaded copy, 2 = pipeline with %d buffers\n",
+            DEFAULT_PIPELINE_DEPTH);
+    fprintf(stderr, "  jobs=N         copy stripes of seekable files with N parallel workers\n");
+    fprintf(stderr, "  clone=MODE     reflink the range: off (default), auto, always\n");
+    fprintf(stderr, "  holes=MODE     skip input holes: off (default), seek, punch\n");
+    fprintf(stderr, "  conv=sparse    seek over all-zero blocks instead of writing them\n");
+    fprintf(stderr, "  prealloc=MODE  preallocate the output: auto (default), off, keep-size\n");
+    fprintf(stderr, "  syncwin=SIZE   write back every SIZE bytes in the background, sync once at the end\n");
+    fprintf(stderr, "  iflag=FLAGS    input flags: direct, dsync, sync, nocache, nonblock, noatime,\n");
+    fprintf(stderr, "                 fullblock, count_bytes, skip_bytes\n");
+    fprintf(stderr, "  oflag=FLAGS    output flags: direct, dsync, sync, nocache, nonblock, noatime,\n");
+    fprintf(stderr, "                 seek_bytes\n");
+    fprintf(stderr, "  platform       show platform-specific capabilities and the topology of if=/of=\n");
+    fprintf(stderr, "  bench[=PATH]   sweep bs and qd for sequential reads and writes on PATH (default: .)\n");
+    fprintf(stderr, "  benchsize=SIZE bytes of the scratch file or device region bench uses (default: 256M)\n");
+    fprintf(stderr, "  status=LEVEL   progress (default, bar on a terminal), noxfer (no transfer statistics), none (errors only)\n");
+    fprintf(stderr, "                 or json (one JSON object with the run report)\n");
+    fprintf(stderr, "  metrics=PATH   serve Prometheus metrics on Unix socket PATH while copying,\n");
+    fprintf(stderr, "                 SIGUSR1 prints the same snapshot to stderr\n");
     fprintf(stderr, "\nSize suffixes: K=1024, M=1024*1024, G=1024*1024*1024\n");
 }
 
 // print platform capabilities and configuration
-static void print_platform_info(void)
+static void print_platform_info(const Options *opts)
 {
     printf("pdd - POSIX platform capabilities:\n");
 
@@ -775,8 +4984,63 @@ static void print_platform_info(void)
 
     printf("Direct I/O support: %s\n", HAVE_DIRECT_IO ? "Yes" : "No");
     printf("Block device size detection: %s\n", HAVE_BLOCK_SIZE_IOCTL ? "Yes" : "No");
+    printf("io_uring engine support: %s\n", HAVE_IO_URING ? "Yes" : "No");
+    printf("splice engine support: %s\n", HAVE_SPLICE ? "Yes" : "No");
+    printf("copy_file_range engine support: %s\n", HAVE_COPY_FILE_RANGE ? "Yes" : "No");
+    printf("Reflink clone support: %s\n", HAVE_CLONE_RANGE ? "Yes" : "No");
+    printf("Zero-block detection: %s\n", zero_block_impl);
     printf("Default block size: %lu bytes\n", (unsigned long)DEFAULT_BLOCK_SIZE);
     printf("Maximum block size: %lu bytes\n", (unsigned long)MAX_BLOCK_SIZE);
+
+    // probe the endpoints named on the command line without creating or truncating them
+    DeviceTopology topos[2];
+    const char *paths[] = {opts->if_path, opts->of_path};
+    const char *labels[] = {"Input", "Output"};
+    bool probed = false;
+    for (size_t i = 0; i < 2; i++)
+    {
+        memset(&topos[i], 0, sizeof(topos[i]));
+        if (strcmp(paths[i], "-") == 0)
+            continue;
+        int fd = open(paths[i], O_RDONLY | O_NONBLOCK);
+        if (fd == -1)
+        {
+            printf("%s topology (%s): %s\n", labels[i], paths[i], strerror(errno));
+            continue;
+        }
+        probe_topology(fd, &topos[i]);
+        close(fd);
+        print_topology(labels[i], paths[i], &topos[i]);
+        probed = true;
+    }
+    if (probed)
+    {
+        size_t depth;
+        size_t block_size = optimize_block_size(&topos[0], &topos[1], &depth);
+        printf("Derived transfer: size=%zu qd=%zu\n", block_size, depth);
+    }
+
+    // show the tuned settings that would replace the derived ones
+    char cache_path[512];
+    if (tuning_cache_path(cache_path, sizeof(cache_path), false))
+    {
+        printf("Tuning cache: %s\n", cache_path);
+        TuningEntry key, cached;
+        int in_fd = strcmp(opts->if_path, "-") == 0 ? dup(STDIN_FILENO) : open(opts->if_path, O_RDONLY | O_NONBLOCK);
+        int out_fd = strcmp(opts->of_path, "-") == 0 ? dup(STDOUT_FILENO) : open(opts->of_path, O_RDONLY | O_NONBLOCK);
+        if (in_fd != -1 && out_fd != -1 && device_key(in_fd, key.in_key, sizeof(key.in_key)) &&
+            device_key(out_fd, key.out_key, sizeof(key.out_key)))
+        {
+            printf("Tuning key: %s %s\n", key.in_key, key.out_key);
+            if (tuning_cache_lookup(&key, &cached))
+                printf("Tuned transfer: size=%zu qd=%zu engine=%s (%.2f MB/s)\n", cached.block_size,
+                       cached.queue_depth, ENGINE_STRINGS[cached.engine], cached.rate);
+        }
+        if (in_fd != -1)
+            close(in_fd);
+        if (out_fd != -1)
+            close(out_fd);
+    }
     printf("\n");
 }
 
@@ -790,17 +5054,38 @@ int main(int argc, char *argv[])
 
     // initialize options with defaults
     Options opts = {
-        .if_path = NULL,
-        .of_path = NULL,
-        .block_size = DEFAULT_BLOCK_SIZE,
+        .if_path = "-",
+        .of_path = "-",
+        .block_size = 0,
+        .auto_block_size = false,
+        .in_block_size = 0,
+        .out_block_size = 0,
         .count = 0,
         .skip = 0,
         .seek = 0,
         .sync_flag = false,
         .direct_flag = false,
-        .fsync_flag = false};
+        .fsync_flag = false,
+        .engine = ENGINE_AUTO,
+        .queue_depth = 0,
+        .pipeline_depth = DEFAULT_PIPELINE_DEPTH,
+        .jobs = 1,
+        .clone = CLONE_OFF,
+        .holes = HOLES_OFF,
+        .conv = 0,
+        .prealloc = PREALLOC_AUTO,
+        .sync_window = 0,
+        .iflags = 0,
+        .oflags = 0,
+        .show_platform = false,
+        .bench_path = NULL,
+        .bench_size = 0,
+        .status = STATUS_PROGRESS,
+        .metrics_path = NULL,
+        .max_memory = 0};
 
     setup_signals();
+    init_zero_detection();
 
     // parse command line arguments
     for (int i = 1; i < argc; i++)
@@ -813,6 +5098,14 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (opts.show_platform)
+    {
+        print_platform_info(&opts);
+        return EXIT_SUCCESS;
+    }
+    if (opts.bench_path)
+        return run_bench(&opts);
+
     validate_options(&opts);
     return copy_file(&opts);
 }
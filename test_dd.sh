@@ -94,6 +94,7 @@ run_performance_test() {
 [ ! -x "./pdd" ] && { echo "Please run 'make' first to build the program"; exit 1; }
 
 rm -rf test_dir; mkdir -p test_dir; cd test_dir
+export XDG_CACHE_HOME="$PWD/cache" # keep tuned settings of this run out of the user's cache
 dd if=/dev/urandom of=input.bin bs=1M count=10 2>/dev/null
 echo "Input file SHA-256: $(command -v sha256sum >/dev/null && sha256sum input.bin | cut -d' ' -f1 || shasum -a 256 input.bin | cut -d' ' -f1)"
 
@@ -115,6 +116,65 @@ tests=(
     "sync I/O:../pdd if=input.bin of=output10.bin bs=4K sync:success:true"
     "stdin: cat input.bin | ../pdd if=- of=output11.bin bs=4K:success:true"
     "fsync after each write:../pdd if=input.bin of=output12.bin bs=1M fsync:success:true"
+    "io_uring engine:../pdd if=input.bin of=output14.bin bs=64K engine=uring qd=16:success:true"
+    "io_uring engine with direct I/O:../pdd if=input.bin of=output15.bin bs=1M engine=uring direct:success:true"
+    "invalid engine:../pdd if=input.bin of=output16.bin engine=bogus:failure"
+    "pipeline engine:../pdd if=input.bin of=output17.bin bs=64K pipeline=8:success:true"
+    "pipeline from stdin: cat input.bin | ../pdd if=- of=output18.bin bs=4K threads=2:success:true"
+    "skip on stdin:(cat input.bin | ../pdd of=output19.bin bs=1M skip=2 && [ \$(get_file_size output19.bin) -eq \$((8*1024*1024)) ]):success"
+    "parallel jobs:../pdd if=input.bin of=output20.bin bs=64K jobs=4:success:true"
+    "parallel jobs with count:(../pdd if=input.bin of=output21.bin bs=1M skip=1 count=7 jobs=3 && [ \$(get_file_size output21.bin) -eq \$((7*1024*1024)) ]):success"
+    "splice from pipe: cat input.bin | ../pdd if=- of=output22.bin bs=64K engine=splice:success:true"
+    "copy_file_range engine:../pdd if=input.bin of=output23.bin bs=256K engine=copy_file_range:success:true"
+    "clone with fallback:../pdd if=input.bin of=output24.bin clone=auto:success:true"
+    "clone records split a short tail:(head -c 1000000 input.bin > clone_tail.bin && ../pdd if=clone_tail.bin of=output24t.bin bs=128K clone=auto status=json > clone_tail.json 2>&1 && grep -q 'records_out....full..7,.partial..1}' clone_tail.json && cmp clone_tail.bin output24t.bin):success"
+    "invalid clone mode:../pdd if=input.bin of=output25.bin clone=sometimes:failure"
+    "skip input holes:(../pdd if=input.bin of=sparse_in.bin bs=1M seek=8 count=1 && ../pdd if=sparse_in.bin of=output26.bin bs=64K holes=seek && cmp sparse_in.bin output26.bin):success"
+    "punch input holes:(../pdd if=sparse_in.bin of=output27.bin bs=64K holes=punch && cmp sparse_in.bin output27.bin):success"
+    "sparse zero blocks:(../pdd if=sparse_in.bin of=output28.bin bs=64K conv=sparse && cmp sparse_in.bin output28.bin):success"
+    "invalid conv flag:../pdd if=input.bin of=output29.bin conv=bogus:failure"
+    "preallocated output:../pdd if=input.bin of=output30.bin bs=1M prealloc=auto:success:true"
+    "keep-size preallocation:../pdd if=input.bin of=output31.bin bs=1M prealloc=keep-size:success:true"
+    "preallocation past short input:(../pdd if=input.bin of=output32.bin bs=1M count=20 && [ \$(get_file_size output32.bin) -eq \$((10*1024*1024)) ]):success"
+    "invalid prealloc mode:../pdd if=input.bin of=output33.bin prealloc=maybe:failure"
+    "write-behind window:../pdd if=input.bin of=output34.bin bs=64K syncwin=1M:success:true"
+    "write-behind across skipped holes:(../pdd if=sparse_in.bin of=output34h.bin bs=64K holes=seek syncwin=1M && cmp sparse_in.bin output34h.bin):success"
+    "write-behind with io_uring:(../pdd if=input.bin of=output34u.bin bs=64K engine=uring qd=16 syncwin=1M && cmp input.bin output34u.bin):success"
+    "write-behind to pipe reader:(cat input.bin | ../pdd of=/dev/null syncwin=1M):success"
+    "page-cache-neutral copy:../pdd if=input.bin of=output35.bin bs=1M iflag=nocache oflag=nocache:success:true"
+    "invalid iflag:../pdd if=input.bin of=output36.bin iflag=bogus:failure"
+    "byte-granular skip and count:(../pdd if=input.bin of=output37.bin bs=64K skip=1000 count=5000 iflag=skip_bytes,count_bytes && [ \$(get_file_size output37.bin) -eq 5000 ] && tail -c +1001 input.bin | head -c 5000 | cmp - output37.bin):success"
+    "byte-granular seek:(../pdd if=input.bin of=output38.bin bs=64K seek=100 count=1 oflag=seek_bytes && [ \$(get_file_size output38.bin) -eq \$((100+64*1024)) ]):success"
+    "direct output with partial tail:(head -c 1000000 input.bin > tail_in.bin && ../pdd if=tail_in.bin of=output39.bin bs=64K iflag=direct oflag=direct,dsync engine=sync && cmp tail_in.bin output39.bin):success"
+    "direct I/O with an unaligned block size:(../pdd if=input.bin of=output58u.bin bs=1000 direct && cmp input.bin output58u.bin):success"
+    "direct output at a misaligned offset fails:../pdd if=input.bin of=output58.bin bs=64K oflag=direct,seek_bytes seek=100:failure"
+    "failed copy trims the preallocation:(if ../pdd if=input.bin of=output58p.bin bs=64K oflag=direct,seek_bytes seek=100; then false; else test \$(get_file_size output58p.bin) -le 100; fi):success"
+    "seek_bytes is not an input flag:../pdd if=input.bin of=output40.bin iflag=seek_bytes:failure"
+    "platform report with topology:../pdd platform if=input.bin:success"
+    "autotuned block size:../pdd if=input.bin of=output42.bin bs=auto engine=sync:success:true"
+    "autotuned block size with io_uring:../pdd if=input.bin of=output43.bin bs=auto engine=uring:success:true"
+    "bs=auto counts default blocks:(../pdd if=input.bin of=output_auto_count.bin bs=auto count=3 skip=2 && dd if=input.bin bs=128K count=3 skip=2 2>/dev/null | cmp - output_auto_count.bin):success"
+    "tuning cache keeps the default block size:(mkdir -p pinned/pdd && printf 'chr=1\\0725 pipe 4194304 1 sync 100.00\\n' > pinned/pdd/tuning && export XDG_CACHE_HOME=\$PWD/pinned && ../pdd platform if=/dev/zero | grep -q 'Tuned transfer.*4194304' && test \$(../pdd if=/dev/zero count=1 status=none | wc -c) -eq 131072):success"
+    "tuning cache sizes the reported transfers:(mkdir -p pinned2/pdd && printf 'chr=1\\0725 chr=1\\0723 4194304 1 sync 100.00\\n' > pinned2/pdd/tuning && export XDG_CACHE_HOME=\$PWD/pinned2 && ../pdd if=/dev/zero of=/dev/null count=64 status=json | grep -q '.block_size..131072,.transfer_size..4194304'):success"
+    "tuning cache keeps the engine of plain copies:(mkdir -p cache/pdd && touch output_engine.bin && key=\$(../pdd platform if=input.bin of=output_engine.bin | awk '/^Tuning key/ {print \$3, \$4}') && before=\$(../pdd if=input.bin of=output_engine.bin status=json | grep -o '.engine....[a-z_]*') && test -n \"\$before\" && printf '%s 524288 1 sync 944.49\\n' \"\$key\" >> cache/pdd/tuning && ../pdd platform if=input.bin of=output_engine.bin | grep -q 'Tuned transfer.*524288' && test \"\$(../pdd if=input.bin of=output_engine.bin status=json | grep -o '.engine....[a-z_]*')\" = \"\$before\"):success"
+    "tuning cache round trip:(../pdd if=/dev/zero of=/dev/null bs=auto iflag=count_bytes count=16G && ../pdd platform if=/dev/zero of=/dev/null | grep -q 'Tuned transfer'):success"
+    "bench with scratch file:(mkdir -p benchdir && ../pdd bench=benchdir benchsize=1M | grep -q 'Recommended for writes' && [ \$(ls -A benchdir | wc -l) -eq 0 ]):success"
+    "bench existing file read only:(../pdd bench=input.bin benchsize=1M > bench_out.txt && grep -q 'Recommended for reads' bench_out.txt && ! grep -q '^write' bench_out.txt):success"
+    "latency percentiles with fsync:(../pdd if=input.bin of=output44.bin bs=64K engine=sync fsync > latency.txt && grep -q 'p99.9' latency.txt && grep -q '^read' latency.txt && grep -q '^sync' latency.txt):success"
+    "json run report:(../pdd if=input.bin of=output45.bin bs=1M status=json > report.json && grep -q '\"records_in\"' report.json && grep -q '\"cpu_s\"' report.json && [ \$(wc -l < report.json) -eq 1 ]):success"
+    "status none is silent:([ -z \"\$(../pdd if=input.bin of=output46.bin bs=1M status=none 2>&1)\" ] && cmp input.bin output46.bin):success"
+    "json report stays off the data stream:(../pdd if=input.bin bs=1M status=json 2>/dev/null | cmp - input.bin):success"
+    "unknown status:../pdd if=input.bin of=output47.bin status=loud:failure"
+    "metrics socket and SIGUSR1 dump:((sleep 1; cat input.bin) | ../pdd of=output48.bin status=none metrics=m.sock 2> metrics.txt & sleep 0.5; [ -S m.sock ] && kill -USR1 \$! && wait \$! && grep -q '^pdd_request_duration_seconds_count' metrics.txt && [ ! -e m.sock ] && cmp input.bin output48.bin):success"
+    "SIGUSR1 dump while the progress thread sleeps:((sleep 1.5; cat input.bin) | ../pdd of=output57.bin 2> dump.txt & sleep 0.5; kill -USR1 \$! && sleep 0.3 && grep -q '^pdd_bytes_copied_total' dump.txt && wait \$! && cmp input.bin output57.bin):success"
+    "no progress escapes off a terminal:((sleep 0.3; cat input.bin) | ../pdd of=output49.bin > progress.txt 2>&1 && ! grep -q \$'\\033' progress.txt && grep -q 'records out' progress.txt && cmp input.bin output49.bin):success"
+    "short copies end without waiting for a progress tick:(start=\$(date +%s%N); for i in \$(seq 20); do ../pdd if=input.bin of=output50.bin bs=1M 2>/dev/null || exit 1; done; [ \$(( (\$(date +%s%N) - start) / 1000000 )) -lt 1500 ]):success"
+    "coalesced bs=512 keeps block offsets:(../pdd if=input.bin of=output51.bin bs=512 skip=3 seek=5 count=777 status=json > coalesce.json && dd if=input.bin of=expected51.bin bs=512 skip=3 seek=5 count=777 2>/dev/null && cmp output51.bin expected51.bin && grep -q 'records_out....full..777,.partial..0}' coalesce.json):success"
+    "coalesced reads pass on blocks from a slow pipe:((head -c 1024 input.bin; sleep 1; head -c 1000 input.bin) | ../pdd of=output52.bin bs=512 status=none & sleep 0.5; [ \$(get_file_size output52.bin) -eq 1024 ] && wait \$! && [ \$(get_file_size output52.bin) -eq 2024 ]):success"
+    "ibs and obs reblock like dd:(../pdd if=input.bin of=output53.bin ibs=1000 obs=3000 skip=5 seek=3 count=777 2>&1 | head -2 > reblock.txt && dd if=input.bin of=expected53.bin ibs=1000 obs=3000 skip=5 seek=3 count=777 2>&1 | head -2 | diff - reblock.txt && cmp output53.bin expected53.bin):success"
+    "partial input record is reblocked:(head -c 5000 input.bin | ../pdd of=output54.bin ibs=512 obs=2K status=none && head -c 5000 input.bin | cmp - output54.bin):success"
+    "large blocks move in chunks within maxmem:(../pdd if=input.bin of=output55.bin bs=3000000 skip=1 seek=2 count=2 maxmem=1M engine=uring qd=4 > chunked.txt && dd if=input.bin of=expected55.bin bs=3000000 skip=1 seek=2 count=2 2>/dev/null && cmp output55.bin expected55.bin && grep -q '^2+0 records out' chunked.txt):success"
+    "maxmem too small for the buffers:../pdd if=input.bin of=output56.bin bs=1M engine=pipeline pipeline=4 maxmem=8K:failure"
     "sparse file creation:(../pdd if=input.bin of=output13.bin bs=1M seek=10 count=1 && [ -f output13.bin ] && [ \$(get_file_size output13.bin) -eq \$((11*1024*1024)) ]):success"
 )
 